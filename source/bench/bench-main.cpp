@@ -0,0 +1,63 @@
+#include "bench/bench.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+    std::atomic<size_t> allocations{0};
+
+}
+
+size_t RS::Sci::Bench::allocation_count() noexcept {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t n) {
+    ++allocations;
+    if (void* p = std::malloc(n > 0 ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void bench_rs_sci_hash_batch();
+void bench_rs_sci_hash_bulk();
+void bench_rs_sci_hash_siphash();
+void bench_rs_sci_hash_throughput();
+void bench_rs_sci_mp_integer_allocation();
+void bench_rs_sci_mp_integer_conversion();
+void bench_rs_sci_mp_integer_hash();
+void bench_rs_sci_mp_integer_multiplication();
+void bench_rs_sci_mp_integer_powmod();
+void bench_rs_sci_prime_count();
+void bench_rs_sci_prime_factor_batch();
+void bench_rs_sci_random_fill();
+void bench_rs_sci_random_generate();
+
+int main(int argc, char** argv) {
+
+    return RS::Sci::Bench::run_benchmarks(argc, argv, {
+        { "hash-throughput", bench_rs_sci_hash_throughput },
+        { "hash-batch", bench_rs_sci_hash_batch },
+        { "hash-siphash", bench_rs_sci_hash_siphash },
+        { "hash-bulk", bench_rs_sci_hash_bulk },
+        { "mp-integer-multiplication", bench_rs_sci_mp_integer_multiplication },
+        { "mp-integer-conversion", bench_rs_sci_mp_integer_conversion },
+        { "mp-integer-allocation", bench_rs_sci_mp_integer_allocation },
+        { "mp-integer-powmod", bench_rs_sci_mp_integer_powmod },
+        { "mp-integer-hash", bench_rs_sci_mp_integer_hash },
+        { "prime-count", bench_rs_sci_prime_count },
+        { "prime-factor-batch", bench_rs_sci_prime_factor_batch },
+        { "random-fill", bench_rs_sci_random_fill },
+        { "random-generate", bench_rs_sci_random_generate },
+    });
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace RS::Sci::Bench {
+
+    // Prevent the compiler from discarding an unused result
+
+    template <typename T>
+    void keep(const T& t) noexcept {
+        #if defined(_MSC_VER)
+            static const volatile void* sink;
+            sink = &t;
+        #else
+            asm volatile("" : : "r,m"(t) : "memory");
+        #endif
+    }
+
+    // Mean time per call in seconds, repeating the call until at least
+    // min_time seconds have elapsed
+
+    template <typename F>
+    double time_per_call(F f, double min_time = 0.1) {
+        using clock = std::chrono::steady_clock;
+        size_t calls = 0;
+        size_t batch = 1;
+        auto start = clock::now();
+        double elapsed = 0;
+        while (elapsed < min_time) {
+            for (size_t i = 0; i < batch; ++i)
+                f();
+            calls += batch;
+            batch *= 2;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        }
+        return elapsed / double(calls);
+    }
+
+    // Number of calls to the global operator new so far (counted by the
+    // replacement allocation functions in bench-main.cpp)
+
+    size_t allocation_count() noexcept;
+
+    // Mean number of heap allocations per call
+
+    template <typename F>
+    double allocations_per_call(F f, size_t calls = 1000) {
+        size_t before = allocation_count();
+        for (size_t i = 0; i < calls; ++i)
+            f();
+        return double(allocation_count() - before) / double(calls);
+    }
+
+    struct Benchmark {
+        std::string name;
+        std::function<void()> run;
+    };
+
+    // Run every benchmark whose name contains one of the command line
+    // arguments, or all of them if there are no arguments
+
+    inline int run_benchmarks(int argc, char** argv, const std::vector<Benchmark>& benchmarks) {
+        for (auto& b: benchmarks) {
+            bool selected = argc < 2;
+            for (int i = 1; i < argc && ! selected; ++i)
+                selected = b.name.find(argv[i]) != std::string::npos;
+            if (selected) {
+                std::printf("\n=== %s ===\n\n", b.name.data());
+                b.run();
+            }
+        }
+        return 0;
+    }
+
+}
@@ -0,0 +1,195 @@
+#include "rs-sci/hash.hpp"
+#include "bench/bench.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+using namespace RS::Sci;
+using namespace RS::Sci::Bench;
+
+namespace {
+
+    template <typename H>
+    double hash_throughput(const std::vector<uint8_t>& data, size_t len) {
+        H hash;
+        typename H::digest_type digest;
+        double t = time_per_call([&] {
+            hash(data.data(), len, digest);
+            keep(digest);
+        });
+        return double(len) / t / 1e6;
+    }
+
+    // Time stamp counter ticks per second, or zero if there is no TSC. On
+    // modern x86 processors the TSC runs at a constant nominal frequency,
+    // so this is only an approximation to core clock cycles.
+
+    double tsc_frequency() {
+        #if defined(__x86_64__) || defined(__i386__)
+            using clock = std::chrono::steady_clock;
+            auto start = clock::now();
+            auto tsc = __rdtsc();
+            double elapsed = 0;
+            while (elapsed < 0.1)
+                elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            return double(__rdtsc() - tsc) / elapsed;
+        #else
+            return 0;
+        #endif
+    }
+
+    template <typename H>
+    double hash_time_per_byte(const std::vector<uint8_t>& data, size_t len) {
+        H hash;
+        double t = time_per_call([&] { keep(hash(data.data(), len)); });
+        return t / double(len);
+    }
+
+    struct BulkHash64 {
+        uint64_t operator()(const void* ptr, size_t len) const noexcept { return bulk_hash64(ptr, len); }
+    };
+
+    struct StdHash {
+        size_t operator()(const void* ptr, size_t len) const noexcept {
+            return std::hash<std::string_view>()(std::string_view(static_cast<const char*>(ptr), len));
+        }
+    };
+
+}
+
+// Throughput of the cryptographic hashes in MB/s, for a range of message
+// sizes, using the allocation free digest interface. SHA-256 uses the SHA
+// extensions if the processor has them.
+
+void bench_rs_sci_hash_throughput() {
+
+    static constexpr size_t sizes[] = { 64, 256, 1024, 16384, 1'048'576 };
+
+    std::vector<uint8_t> data(sizes[std::size(sizes) - 1]);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t(i * 37);
+
+    std::printf("SHA-256 hardware acceleration: %s\n", SHA256::hardware_accelerated() ? "yes" : "no");
+    std::printf("Throughput in MB/s\n\n");
+    std::printf("%8s  %10s  %10s  %10s  %10s\n", "Bytes", "MD5", "SHA1", "SHA256", "SHA512");
+
+    for (auto len: sizes)
+        std::printf("%8zu  %10.1f  %10.1f  %10.1f  %10.1f\n", len,
+            hash_throughput<MD5>(data, len),
+            hash_throughput<SHA1>(data, len),
+            hash_throughput<SHA256>(data, len),
+            hash_throughput<SHA512>(data, len));
+
+    SHA256 hash;
+    SHA256::digest_type digest;
+    std::printf("\nAllocations per message: %.3f\n",
+        allocations_per_call([&] { hash(data.data(), 64, digest); }));
+
+}
+
+// Hashing many small records one at a time, and with the batch functions.
+// Record lengths vary from 32 to 256 bytes. Times are per record.
+
+void bench_rs_sci_hash_batch() {
+
+    static constexpr size_t count = 100'000;
+
+    std::vector<uint8_t> data(count * 256);
+    std::vector<const void*> ptrs(count);
+    std::vector<size_t> lens(count);
+
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t(i * 37);
+    for (size_t i = 0; i < count; ++i) {
+        ptrs[i] = data.data() + 256 * i;
+        lens[i] = 32 + (i * 97) % 225;
+    }
+
+    SipHash sip;
+    SHA256 sha;
+    std::vector<uint64_t> sip_out(count);
+    std::vector<SHA256::digest_type> sha_out(count);
+
+    double sip_single = time_per_call([&] {
+        for (size_t i = 0; i < count; ++i)
+            sip_out[i] = sip(ptrs[i], lens[i]);
+        keep(sip_out);
+    });
+    double sip_batch = time_per_call([&] {
+        sip.hash_batch(ptrs.data(), lens.data(), count, sip_out.data());
+        keep(sip_out);
+    });
+    double sha_single = time_per_call([&] {
+        for (size_t i = 0; i < count; ++i)
+            sha(ptrs[i], lens[i], sha_out[i]);
+        keep(sha_out);
+    });
+    double sha_batch = time_per_call([&] {
+        SHA256::hash_batch(ptrs.data(), lens.data(), count, sha_out.data());
+        keep(sha_out);
+    });
+
+    std::printf("%8s  %12s  %12s\n", "", "Single", "Batch");
+    std::printf("%8s  %10.1fns  %10.1fns\n", "SipHash", 1e9 * sip_single / count, 1e9 * sip_batch / count);
+    std::printf("%8s  %10.1fns  %10.1fns\n", "SHA256", 1e9 * sha_single / count, 1e9 * sha_batch / count);
+
+}
+
+// SipHash and HalfSipHash variants, for a range of message sizes, in cycles
+// per byte, or in nanoseconds per byte where there is no time stamp counter
+
+void bench_rs_sci_hash_siphash() {
+
+    static constexpr size_t sizes[] = { 8, 16, 64, 256, 4096 };
+
+    std::vector<uint8_t> data(sizes[std::size(sizes) - 1]);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t(i * 37);
+
+    double tsc = tsc_frequency();
+    double scale = tsc > 0 ? tsc : 1e9;
+
+    std::printf("%s per byte\n\n", tsc > 0 ? "Cycles" : "Nanoseconds");
+    std::printf("%8s  %10s  %10s  %12s  %14s\n", "Bytes", "SipHash", "SipHash13", "HalfSipHash", "HalfSipHash13");
+
+    for (auto len: sizes)
+        std::printf("%8zu  %10.2f  %10.2f  %12.2f  %14.2f\n", len,
+            scale * hash_time_per_byte<SipHash>(data, len),
+            scale * hash_time_per_byte<SipHash13>(data, len),
+            scale * hash_time_per_byte<HalfSipHash>(data, len),
+            scale * hash_time_per_byte<HalfSipHash13>(data, len));
+
+}
+
+// Cost of the bulk hash in cycles per byte (or nanoseconds if there is no
+// time stamp counter), compared with SipHash-1-3 and the standard library's
+// string hash
+
+void bench_rs_sci_hash_bulk() {
+
+    static constexpr size_t sizes[] = { 8, 16, 64, 256, 1024, 16384, 1'048'576 };
+
+    std::vector<uint8_t> data(sizes[std::size(sizes) - 1]);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t(i * 37);
+
+    double tsc = tsc_frequency();
+    double scale = tsc > 0 ? tsc : 1e9;
+
+    std::printf("%s per byte\n\n", tsc > 0 ? "Cycles" : "Nanoseconds");
+    std::printf("%8s  %10s  %10s  %10s\n", "Bytes", "BulkHash", "SipHash13", "std::hash");
+
+    for (auto len: sizes)
+        std::printf("%8zu  %10.3f  %10.3f  %10.3f\n", len,
+            scale * hash_time_per_byte<BulkHash64>(data, len),
+            scale * hash_time_per_byte<SipHash13>(data, len),
+            scale * hash_time_per_byte<StdHash>(data, len));
+
+}
@@ -0,0 +1,219 @@
+#include "rs-sci/mp-integer.hpp"
+#include "rs-sci/random-engines.hpp"
+#include "bench/bench.hpp"
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace RS::Sci;
+using namespace RS::Sci::Bench;
+
+namespace {
+
+    // Little endian hosts only
+
+    MPN random_mpn(Pcg64& rng, size_t limbs) {
+        std::vector<MPN::limb_type> v(limbs);
+        for (auto& w: v)
+            w = MPN::limb_type(rng());
+        v.back() |= MPN::limb_type(1) << (MPN::limb_bits - 1);
+        return MPN::read_le(v.data(), sizeof(MPN::limb_type) * limbs);
+    }
+
+}
+
+// Times each multiplication algorithm on square products of increasing size.
+// The fastest algorithm at each size is marked; the points where the marker
+// moves are the crossovers to use for RS_SCI_MPN_KARATSUBA_THRESHOLD,
+// RS_SCI_MPN_TOOM3_THRESHOLD, and RS_SCI_MPN_NTT_THRESHOLD. Long
+// multiplication is skipped for the largest sizes.
+
+void bench_rs_sci_mp_integer_multiplication() {
+
+    static constexpr size_t sizes[] = {
+        8, 12, 16, 20, 24, 28, 32, 40, 48, 64, 80, 96, 112, 128,
+        160, 192, 224, 256, 320, 384, 512, 768, 1024, 1536, 2048, 3072,
+        4096, 6144, 8192, 16384, 32768, 65536,
+    };
+
+    static constexpr MulAlgorithm algorithms[] = {
+        MulAlgorithm::schoolbook,
+        MulAlgorithm::karatsuba,
+        MulAlgorithm::toom3,
+        MulAlgorithm::ntt,
+        MulAlgorithm::automatic,
+    };
+
+    static constexpr int n_algorithms = int(std::size(algorithms));
+    static constexpr size_t max_schoolbook = 8192;
+
+    Pcg64 rng(42);
+
+    std::printf("%8s  %14s  %14s  %14s  %14s  %14s\n", "Limbs", "Schoolbook", "Karatsuba", "Toom-3", "NTT", "Automatic");
+
+    for (auto n: sizes) {
+
+        auto x = random_mpn(rng, n);
+        auto y = random_mpn(rng, n);
+        double times[n_algorithms];
+
+        for (int i = 0; i < n_algorithms; ++i) {
+            if (algorithms[i] == MulAlgorithm::schoolbook && n > max_schoolbook)
+                times[i] = 0;
+            else
+                times[i] = time_per_call([&] { keep(multiply(x, y, algorithms[i])); });
+        }
+
+        int best = -1;
+        for (int i = 0; i < n_algorithms - 1; ++i)
+            if (times[i] > 0 && (best == -1 || times[i] < times[best]))
+                best = i;
+
+        std::printf("%8zu", n);
+        for (int i = 0; i < n_algorithms; ++i) {
+            if (times[i] == 0)
+                std::printf("  %14s", "-");
+            else
+                std::printf("  %12.3fus%s", 1e6 * times[i], i == best ? "*" : " ");
+        }
+        std::printf("\n");
+
+    }
+
+}
+
+// Times conversion to and from decimal and hexadecimal strings. The radix
+// split threshold and the Barrett division threshold used by the decimal
+// conversions can be checked against this.
+
+void bench_rs_sci_mp_integer_conversion() {
+
+    static constexpr size_t sizes[] = {
+        4, 16, 64, 256, 1024, 4096, 16384, 65536,
+    };
+
+    Pcg64 rng(42);
+
+    std::printf("%8s  %14s  %14s  %14s  %14s\n", "Limbs", "To decimal", "From decimal", "To hex", "From hex");
+
+    for (auto n: sizes) {
+        auto x = random_mpn(rng, n);
+        auto dec = x.str();
+        auto hex = x.str("x");
+        std::printf("%8zu", n);
+        std::printf("  %12.3fus", 1e6 * time_per_call([&] { keep(x.str()); }));
+        std::printf("  %12.3fus", 1e6 * time_per_call([&] { keep(MPN(dec)); }));
+        std::printf("  %12.3fus", 1e6 * time_per_call([&] { keep(x.str("x")); }));
+        std::printf("  %12.3fus", 1e6 * time_per_call([&] { keep(MPN(hex, 16)); }));
+        std::printf("\n");
+    }
+
+}
+
+// Counts heap allocations and times the common operations on small integers
+// (up to 256 bits), which should fit in the inline limb storage. The last
+// two rows compare an expression with temporaries against the three operand
+// functions reusing one destination.
+
+void bench_rs_sci_mp_integer_allocation() {
+
+    static constexpr int bit_sizes[] = { 64, 128, 192, 256 };
+
+    Pcg64 rng(42);
+
+    std::printf("%6s  %-10s  %12s  %14s\n", "Bits", "Operation", "Allocations", "Time");
+
+    for (auto bits: bit_sizes) {
+
+        size_t limbs = size_t(bits / MPN::limb_bits);
+        auto a = random_mpn(rng, limbs);
+        auto b = random_mpn(rng, limbs) >> (MPN::limb_bits / 2);
+        auto x = a >> (bits / 2);
+        auto y = b >> (bits / 2);
+        MPZ sa = a, sb = - MPZ(b);
+        MPN t;
+
+        auto report = [bits] (const char* name, auto f) {
+            double count = allocations_per_call(f);
+            double time = time_per_call(f);
+            std::printf("%6d  %-10s  %12.2f  %12.3fns\n", bits, name, count, 1e9 * time);
+        };
+
+        report("copy", [&] { MPN z = a; keep(z); });
+        report("add", [&] { keep(a + b); });
+        report("subtract", [&] { keep(a - b); });
+        report("multiply", [&] { keep(x * y); });
+        report("divide", [&] { keep(a / b); });
+        report("shift", [&] { keep(a << 7); });
+        report("mpz add", [&] { keep(sa + sb); });
+        report("mpz mul", [&] { keep(MPZ(x) * MPZ(y)); });
+        report("a*b+c*d", [&] { keep(a * b + x * y); });
+        report("fused", [&] { multiply(t, a, b); addmul(t, x, y); keep(t); });
+        std::printf("\n");
+
+    }
+
+}
+
+// Times modular exponentiation with a full size exponent: square and
+// multiply with a division after each step, powmod(), and pow() on a
+// MontgomeryContext constructed in advance.
+
+void bench_rs_sci_mp_integer_powmod() {
+
+    static constexpr int bit_sizes[] = { 256, 512, 1024, 2048, 4096 };
+
+    Pcg64 rng(42);
+
+    std::printf("%6s  %14s  %14s  %14s\n", "Bits", "Divide", "Powmod", "Context");
+
+    for (auto bits: bit_sizes) {
+
+        size_t limbs = size_t(bits / MPN::limb_bits);
+        auto m = random_mpn(rng, limbs) | 1;
+        auto x = random_mpn(rng, limbs) % m;
+        auto n = random_mpn(rng, limbs);
+        MontgomeryContext context(m);
+
+        auto divide_pow = [&] {
+            MPN a = x, z = 1;
+            for (size_t i = n.bits() - 1; i != std::string::npos; --i) {
+                z = z * z % m;
+                if (n.get_bit(i))
+                    z = z * a % m;
+            }
+            return z;
+        };
+
+        std::printf("%6d", bits);
+        std::printf("  %12.3fus", 1e6 * time_per_call([&] { keep(divide_pow()); }));
+        std::printf("  %12.3fus", 1e6 * time_per_call([&] { keep(powmod(x, n, m)); }));
+        std::printf("  %12.3fus", 1e6 * time_per_call([&] { keep(context.pow(x, n)); }));
+        std::printf("\n");
+
+    }
+
+}
+
+// Compares the bulk byte hash of MPN values with the legacy per-word hash.
+
+void bench_rs_sci_mp_integer_hash() {
+
+    static constexpr size_t sizes[] = {
+        1, 2, 4, 16, 64, 256, 1024,
+    };
+
+    Pcg64 rng(42);
+
+    std::printf("%8s  %14s  %14s\n", "Limbs", "Hash", "Legacy hash");
+
+    for (auto n: sizes) {
+        auto x = random_mpn(rng, n);
+        std::printf("%8zu", n);
+        std::printf("  %12.3fns", 1e9 * time_per_call([&] { keep(x.hash()); }));
+        std::printf("  %12.3fns", 1e9 * time_per_call([&] { keep(x.legacy_hash()); }));
+        std::printf("\n");
+    }
+
+}
@@ -0,0 +1,60 @@
+#include "rs-sci/prime.hpp"
+#include "rs-sci/random-engines.hpp"
+#include "bench/bench.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace RS::Sci;
+using namespace RS::Sci::Bench;
+
+// Times prime_count() against a single threaded sieve count over the same
+// range, for powers of 10. The sieve is skipped for the largest arguments.
+
+void bench_rs_sci_prime_count() {
+
+    static constexpr uint64_t max_sieve = 10'000'000'000;
+
+    std::printf("%20s  %20s  %14s  %14s\n", "x", "pi(x)", "Sieve", "prime_count");
+
+    for (uint64_t x = 1'000'000; x <= 100'000'000'000'000; x *= 10) {
+        uint64_t pi = prime_count(x);
+        std::printf("%20llu  %20llu", static_cast<unsigned long long>(x), static_cast<unsigned long long>(pi));
+        if (x <= max_sieve)
+            std::printf("  %13.3fs", time_per_call([x] { keep(parallel_prime_count(0, x, 1)); }));
+        else
+            std::printf("  %14s", "-");
+        std::printf("  %13.3fs\n", time_per_call([x] { keep(prime_count(x)); }));
+    }
+
+}
+
+// Times factor_batch() against prime_factors() on each value, for a batch of
+// random 32 or 48 bit numbers. The batch is single threaded here, so the
+// comparison only reflects the shared table and cheaper arithmetic.
+
+void bench_rs_sci_prime_factor_batch() {
+
+    static constexpr size_t batch_size = 100'000;
+
+    Pcg64 rng(42);
+
+    std::printf("%6s  %14s  %14s\n", "Bits", "prime_factors", "factor_batch");
+
+    for (int bits: { 32, 48 }) {
+
+        std::vector<uint64_t> values(batch_size);
+        for (auto& x: values)
+            x = rng() >> (64 - bits);
+
+        double single = time_per_call([&values] {
+            for (auto x: values)
+                keep(prime_factors(x));
+        });
+        double batch = time_per_call([&values] { keep(factor_batch(values, 1)); });
+
+        std::printf("%6d  %13.3fs  %13.3fs\n", bits, single, batch);
+
+    }
+
+}
@@ -0,0 +1,89 @@
+#include "rs-sci/random-continuous-distributions.hpp"
+#include "rs-sci/random-discrete-distributions.hpp"
+#include "rs-sci/random-engines.hpp"
+#include "bench/bench.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using namespace RS::Sci;
+using namespace RS::Sci::Bench;
+
+namespace {
+
+    template <typename RNG>
+    double ns_per_value(std::vector<uint64_t>& buffer) {
+        RNG rng(42);
+        double t = time_per_call([&] {
+            for (auto& x: buffer)
+                x = rng();
+            keep(buffer.back());
+        });
+        return 1e9 * t / double(buffer.size());
+    }
+
+    // The two versions are timed alternately, keeping the best time for
+    // each, so neither one gains from running first or second
+
+    template <typename Dist, typename RNG>
+    void compare_generate(const char* name, const Dist& dist, RNG& rng) {
+        using T = typename Dist::result_type;
+        static constexpr int rounds = 5;
+        std::vector<T> buffer(16'384);
+        double call = 1, bulk = 1;
+        for (int i = 0; i < rounds; ++i) {
+            call = std::min(call, time_per_call([&] {
+                for (auto& x: buffer)
+                    x = dist(rng);
+                keep(buffer.back());
+            }, 0.02));
+            bulk = std::min(bulk, time_per_call([&] {
+                dist.generate(rng, buffer.data(), buffer.size());
+                keep(buffer.back());
+            }, 0.02));
+        }
+        double n = double(buffer.size());
+        std::printf("%-32s  %10.3f  %10.3f\n", name, 1e9 * call / n, 1e9 * bulk / n);
+    }
+
+}
+
+// Time per 64-bit value for the scalar engines, and for XoshiroX8 called
+// one value at a time or filling a buffer.
+
+void bench_rs_sci_random_fill() {
+
+    static constexpr size_t size = 65'536;
+
+    std::vector<uint64_t> buffer(size);
+    XoshiroX8 x8(42);
+
+    std::printf("%-24s  %10s\n", "Engine", "ns/value");
+    std::printf("%-24s  %10.3f\n", "Lcg64", ns_per_value<Lcg64>(buffer));
+    std::printf("%-24s  %10.3f\n", "Pcg64", ns_per_value<Pcg64>(buffer));
+    std::printf("%-24s  %10.3f\n", "Xoshiro", ns_per_value<Xoshiro>(buffer));
+    std::printf("%-24s  %10.3f\n", "XoshiroX8::operator()", ns_per_value<XoshiroX8>(buffer));
+    std::printf("%-24s  %10.3f\n", "XoshiroX8::fill()", 1e9 * time_per_call([&] {
+        x8.fill(buffer.data(), size);
+        keep(buffer.back());
+    }) / double(size));
+
+}
+
+// Time per value for some distributions, called one value at a time or
+// through generate().
+
+void bench_rs_sci_random_generate() {
+
+    Pcg64 pcg(42);
+    XoshiroX8 x8(42);
+
+    std::printf("%-32s  %10s  %10s\n", "Distribution", "operator()", "generate()");
+    compare_generate("UniformReal<double> + Pcg64", UniformReal<double>(), pcg);
+    compare_generate("UniformReal<double> + XoshiroX8", UniformReal<double>(), x8);
+    compare_generate("Normal<double> + Pcg64", NormalDistribution<double>(), pcg);
+    compare_generate("Normal<double> + XoshiroX8", NormalDistribution<double>(), x8);
+    compare_generate("UniformInteger<int> + Pcg64", UniformInteger<int>(1, 6), pcg);
+    compare_generate("Poisson<int> + Pcg64", PoissonDistribution<int>(100), pcg);
+
+}
@@ -1,4 +1,7 @@
 #include "rs-sci/hash.hpp"
+#include <algorithm>
+#include <atomic>
+#include <new>
 
 #if defined(__APPLE__)
     #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
@@ -12,8 +15,839 @@
     #include <wincrypt.h>
 #endif
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define RS_SCI_HASH_X86 1
+    #include <cpuid.h>
+    #include <immintrin.h>
+#endif
+
 namespace RS::Sci {
 
+    namespace {
+
+        // The native APIs take a 32-bit length, so longer blocks of data
+        // are passed to them in pieces
+
+        constexpr size_t max_native_update = size_t(1) << 30;
+
+        // Set by Detail::set_hash_extensions()
+
+        std::atomic<unsigned> allowed_extensions{Detail::hash_use_all};
+
+        // SHA-2 (FIPS 180-4)
+
+        constexpr uint32_t sha256_k[64] = {
+            0x428a'2f98u, 0x7137'4491u, 0xb5c0'fbcfu, 0xe9b5'dba5u, 0x3956'c25bu, 0x59f1'11f1u, 0x923f'82a4u, 0xab1c'5ed5u,
+            0xd807'aa98u, 0x1283'5b01u, 0x2431'85beu, 0x550c'7dc3u, 0x72be'5d74u, 0x80de'b1feu, 0x9bdc'06a7u, 0xc19b'f174u,
+            0xe49b'69c1u, 0xefbe'4786u, 0x0fc1'9dc6u, 0x240c'a1ccu, 0x2de9'2c6fu, 0x4a74'84aau, 0x5cb0'a9dcu, 0x76f9'88dau,
+            0x983e'5152u, 0xa831'c66du, 0xb003'27c8u, 0xbf59'7fc7u, 0xc6e0'0bf3u, 0xd5a7'9147u, 0x06ca'6351u, 0x1429'2967u,
+            0x27b7'0a85u, 0x2e1b'2138u, 0x4d2c'6dfcu, 0x5338'0d13u, 0x650a'7354u, 0x766a'0abbu, 0x81c2'c92eu, 0x9272'2c85u,
+            0xa2bf'e8a1u, 0xa81a'664bu, 0xc24b'8b70u, 0xc76c'51a3u, 0xd192'e819u, 0xd699'0624u, 0xf40e'3585u, 0x106a'a070u,
+            0x19a4'c116u, 0x1e37'6c08u, 0x2748'774cu, 0x34b0'bcb5u, 0x391c'0cb3u, 0x4ed8'aa4au, 0x5b9c'ca4fu, 0x682e'6ff3u,
+            0x748f'82eeu, 0x78a5'636fu, 0x84c8'7814u, 0x8cc7'0208u, 0x90be'fffau, 0xa450'6cebu, 0xbef9'a3f7u, 0xc671'78f2u
+        };
+
+        constexpr uint32_t sha256_h[8] = {
+            0x6a09'e667u, 0xbb67'ae85u, 0x3c6e'f372u, 0xa54f'f53au, 0x510e'527fu, 0x9b05'688cu, 0x1f83'd9abu, 0x5be0'cd19u
+        };
+
+        constexpr uint64_t sha512_k[80] = {
+            0x428a'2f98'd728'ae22ull, 0x7137'4491'23ef'65cdull, 0xb5c0'fbcf'ec4d'3b2full, 0xe9b5'dba5'8189'dbbcull,
+            0x3956'c25b'f348'b538ull, 0x59f1'11f1'b605'd019ull, 0x923f'82a4'af19'4f9bull, 0xab1c'5ed5'da6d'8118ull,
+            0xd807'aa98'a303'0242ull, 0x1283'5b01'4570'6fbeull, 0x2431'85be'4ee4'b28cull, 0x550c'7dc3'd5ff'b4e2ull,
+            0x72be'5d74'f27b'896full, 0x80de'b1fe'3b16'96b1ull, 0x9bdc'06a7'25c7'1235ull, 0xc19b'f174'cf69'2694ull,
+            0xe49b'69c1'9ef1'4ad2ull, 0xefbe'4786'384f'25e3ull, 0x0fc1'9dc6'8b8c'd5b5ull, 0x240c'a1cc'77ac'9c65ull,
+            0x2de9'2c6f'592b'0275ull, 0x4a74'84aa'6ea6'e483ull, 0x5cb0'a9dc'bd41'fbd4ull, 0x76f9'88da'8311'53b5ull,
+            0x983e'5152'ee66'dfabull, 0xa831'c66d'2db4'3210ull, 0xb003'27c8'98fb'213full, 0xbf59'7fc7'beef'0ee4ull,
+            0xc6e0'0bf3'3da8'8fc2ull, 0xd5a7'9147'930a'a725ull, 0x06ca'6351'e003'826full, 0x1429'2967'0a0e'6e70ull,
+            0x27b7'0a85'46d2'2ffcull, 0x2e1b'2138'5c26'c926ull, 0x4d2c'6dfc'5ac4'2aedull, 0x5338'0d13'9d95'b3dfull,
+            0x650a'7354'8baf'63deull, 0x766a'0abb'3c77'b2a8ull, 0x81c2'c92e'47ed'aee6ull, 0x9272'2c85'1482'353bull,
+            0xa2bf'e8a1'4cf1'0364ull, 0xa81a'664b'bc42'3001ull, 0xc24b'8b70'd0f8'9791ull, 0xc76c'51a3'0654'be30ull,
+            0xd192'e819'd6ef'5218ull, 0xd699'0624'5565'a910ull, 0xf40e'3585'5771'202aull, 0x106a'a070'32bb'd1b8ull,
+            0x19a4'c116'b8d2'd0c8ull, 0x1e37'6c08'5141'ab53ull, 0x2748'774c'df8e'eb99ull, 0x34b0'bcb5'e19b'48a8ull,
+            0x391c'0cb3'c5c9'5a63ull, 0x4ed8'aa4a'e341'8acbull, 0x5b9c'ca4f'7763'e373ull, 0x682e'6ff3'd6b2'b8a3ull,
+            0x748f'82ee'5def'b2fcull, 0x78a5'636f'4317'2f60ull, 0x84c8'7814'a1f0'ab72ull, 0x8cc7'0208'1a64'39ecull,
+            0x90be'fffa'2363'1e28ull, 0xa450'6ceb'de82'bde9ull, 0xbef9'a3f7'b2c6'7915ull, 0xc671'78f2'e372'532bull,
+            0xca27'3ece'ea26'619cull, 0xd186'b8c7'21c0'c207ull, 0xeada'7dd6'cde0'eb1eull, 0xf57d'4f7f'ee6e'd178ull,
+            0x06f0'67aa'7217'6fbaull, 0x0a63'7dc5'a2c8'98a6ull, 0x113f'9804'bef9'0daeull, 0x1b71'0b35'131c'471bull,
+            0x28db'77f5'2304'7d84ull, 0x32ca'ab7b'40c7'2493ull, 0x3c9e'be0a'15c9'bebcull, 0x431d'67c4'9c10'0d4cull,
+            0x4cc5'd4be'cb3e'42b6ull, 0x597f'299c'fc65'7e2aull, 0x5fcb'6fab'3ad6'faecull, 0x6c44'198c'4a47'5817ull
+        };
+
+        constexpr uint64_t sha512_h[8] = {
+            0x6a09'e667'f3bc'c908ull, 0xbb67'ae85'84ca'a73bull, 0x3c6e'f372'fe94'f82bull, 0xa54f'f53a'5f1d'36f1ull,
+            0x510e'527f'ade6'82d1ull, 0x9b05'688c'2b3e'6c1full, 0x1f83'd9ab'fb41'bd6bull, 0x5be0'cd19'137e'2179ull
+        };
+
+        uint32_t load_be32(const uint8_t* ptr) noexcept {
+            return (uint32_t(ptr[0]) << 24) | (uint32_t(ptr[1]) << 16) | (uint32_t(ptr[2]) << 8) | uint32_t(ptr[3]);
+        }
+
+        uint64_t load_be64(const uint8_t* ptr) noexcept {
+            return (uint64_t(load_be32(ptr)) << 32) | load_be32(ptr + 4);
+        }
+
+        void store_be32(uint32_t x, uint8_t* ptr) noexcept {
+            for (int i = 3; i >= 0; --i, x >>= 8)
+                ptr[i] = uint8_t(x);
+        }
+
+        void store_be64(uint64_t x, uint8_t* ptr) noexcept {
+            store_be32(uint32_t(x >> 32), ptr);
+            store_be32(uint32_t(x), ptr + 4);
+        }
+
+        // One round of the compression function. Instead of moving every
+        // working variable along by one place, only d and h are updated,
+        // and the caller rotates the roles of the variables.
+
+        inline void sha256_round(uint32_t a, uint32_t b, uint32_t c, uint32_t& d,
+                uint32_t e, uint32_t f, uint32_t g, uint32_t& h, uint32_t kw) noexcept {
+            h += (TL::rotr(e, 6) ^ TL::rotr(e, 11) ^ TL::rotr(e, 25)) + (g ^ (e & (f ^ g))) + kw;
+            d += h;
+            h += (TL::rotr(a, 2) ^ TL::rotr(a, 13) ^ TL::rotr(a, 22)) + ((a & b) | (c & (a | b)));
+        }
+
+        inline void sha512_round(uint64_t a, uint64_t b, uint64_t c, uint64_t& d,
+                uint64_t e, uint64_t f, uint64_t g, uint64_t& h, uint64_t kw) noexcept {
+            h += (TL::rotr(e, 14) ^ TL::rotr(e, 18) ^ TL::rotr(e, 41)) + (g ^ (e & (f ^ g))) + kw;
+            d += h;
+            h += (TL::rotr(a, 28) ^ TL::rotr(a, 34) ^ TL::rotr(a, 39)) + ((a & b) | (c & (a | b)));
+        }
+
+        void sha256_blocks_portable(uint32_t* state, const uint8_t* data, size_t blocks) noexcept {
+
+            uint32_t w[64];
+
+            for (; blocks > 0; --blocks, data += 64) {
+
+                for (int i = 0; i < 16; ++i)
+                    w[i] = load_be32(data + 4 * i);
+
+                for (int i = 16; i < 64; ++i) {
+                    uint32_t s0 = TL::rotr(w[i - 15], 7) ^ TL::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                    uint32_t s1 = TL::rotr(w[i - 2], 17) ^ TL::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+                }
+
+                uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+                    e = state[4], f = state[5], g = state[6], h = state[7];
+
+                for (int i = 0; i < 64; i += 8) {
+                    sha256_round(a, b, c, d, e, f, g, h, sha256_k[i] + w[i]);
+                    sha256_round(h, a, b, c, d, e, f, g, sha256_k[i + 1] + w[i + 1]);
+                    sha256_round(g, h, a, b, c, d, e, f, sha256_k[i + 2] + w[i + 2]);
+                    sha256_round(f, g, h, a, b, c, d, e, sha256_k[i + 3] + w[i + 3]);
+                    sha256_round(e, f, g, h, a, b, c, d, sha256_k[i + 4] + w[i + 4]);
+                    sha256_round(d, e, f, g, h, a, b, c, sha256_k[i + 5] + w[i + 5]);
+                    sha256_round(c, d, e, f, g, h, a, b, sha256_k[i + 6] + w[i + 6]);
+                    sha256_round(b, c, d, e, f, g, h, a, sha256_k[i + 7] + w[i + 7]);
+                }
+
+                state[0] += a;
+                state[1] += b;
+                state[2] += c;
+                state[3] += d;
+                state[4] += e;
+                state[5] += f;
+                state[6] += g;
+                state[7] += h;
+
+            }
+
+        }
+
+        void sha512_blocks_portable(uint64_t* state, const uint8_t* data, size_t blocks) noexcept {
+
+            uint64_t w[80];
+
+            for (; blocks > 0; --blocks, data += 128) {
+
+                for (int i = 0; i < 16; ++i)
+                    w[i] = load_be64(data + 8 * i);
+
+                for (int i = 16; i < 80; ++i) {
+                    uint64_t s0 = TL::rotr(w[i - 15], 1) ^ TL::rotr(w[i - 15], 8) ^ (w[i - 15] >> 7);
+                    uint64_t s1 = TL::rotr(w[i - 2], 19) ^ TL::rotr(w[i - 2], 61) ^ (w[i - 2] >> 6);
+                    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+                }
+
+                uint64_t a = state[0], b = state[1], c = state[2], d = state[3],
+                    e = state[4], f = state[5], g = state[6], h = state[7];
+
+                for (int i = 0; i < 80; i += 8) {
+                    sha512_round(a, b, c, d, e, f, g, h, sha512_k[i] + w[i]);
+                    sha512_round(h, a, b, c, d, e, f, g, sha512_k[i + 1] + w[i + 1]);
+                    sha512_round(g, h, a, b, c, d, e, f, sha512_k[i + 2] + w[i + 2]);
+                    sha512_round(f, g, h, a, b, c, d, e, sha512_k[i + 3] + w[i + 3]);
+                    sha512_round(e, f, g, h, a, b, c, d, sha512_k[i + 4] + w[i + 4]);
+                    sha512_round(d, e, f, g, h, a, b, c, sha512_k[i + 5] + w[i + 5]);
+                    sha512_round(c, d, e, f, g, h, a, b, sha512_k[i + 6] + w[i + 6]);
+                    sha512_round(b, c, d, e, f, g, h, a, sha512_k[i + 7] + w[i + 7]);
+                }
+
+                state[0] += a;
+                state[1] += b;
+                state[2] += c;
+                state[3] += d;
+                state[4] += e;
+                state[5] += f;
+                state[6] += g;
+                state[7] += h;
+
+            }
+
+        }
+
+        #ifdef RS_SCI_HASH_X86
+
+            // SHA-256 using the Intel SHA extensions. The state is kept in
+            // two registers, as ABEF and CDGH, the order the sha256rnds2
+            // instruction expects.
+
+            #define RS_SCI_SHA_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+            // Four rounds, using message words 4g to 4g+3
+
+            RS_SCI_SHA_TARGET inline void sha256_rounds_shani(__m128i& state0, __m128i& state1, __m128i msg, int g) noexcept {
+                msg = _mm_add_epi32(msg, _mm_loadu_si128(reinterpret_cast<const __m128i*>(sha256_k + 4 * g)));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+                msg = _mm_shuffle_epi32(msg, 0x0e);
+                state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            }
+
+            // Message words 4g to 4g+3, from the previous four groups
+
+            RS_SCI_SHA_TARGET inline __m128i sha256_schedule_shani(__m128i w4, __m128i w3, __m128i w2, __m128i w1) noexcept {
+                __m128i w = _mm_add_epi32(_mm_sha256msg1_epu32(w4, w3), _mm_alignr_epi8(w1, w2, 4));
+                return _mm_sha256msg2_epu32(w, w1);
+            }
+
+            RS_SCI_SHA_TARGET void sha256_blocks_shani(uint32_t* state, const uint8_t* data, size_t blocks) noexcept {
+
+                const __m128i byte_swap = _mm_set_epi64x(0x0c0d'0e0f'0809'0a0bll, 0x0405'0607'0001'0203ll);
+
+                __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1); // CDAB
+                __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b); // EFGH
+                __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+                state1 = _mm_blend_epi16(state1, tmp, 0xf0); // CDGH
+
+                for (; blocks > 0; --blocks, data += 64) {
+
+                    __m128i save0 = state0;
+                    __m128i save1 = state1;
+
+                    __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), byte_swap);
+                    __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), byte_swap);
+                    __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), byte_swap);
+                    __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), byte_swap);
+
+                    sha256_rounds_shani(state0, state1, w0, 0);
+                    sha256_rounds_shani(state0, state1, w1, 1);
+                    sha256_rounds_shani(state0, state1, w2, 2);
+                    sha256_rounds_shani(state0, state1, w3, 3);
+
+                    for (int g = 4; g < 16; g += 4) {
+                        w0 = sha256_schedule_shani(w0, w1, w2, w3);
+                        sha256_rounds_shani(state0, state1, w0, g);
+                        w1 = sha256_schedule_shani(w1, w2, w3, w0);
+                        sha256_rounds_shani(state0, state1, w1, g + 1);
+                        w2 = sha256_schedule_shani(w2, w3, w0, w1);
+                        sha256_rounds_shani(state0, state1, w2, g + 2);
+                        w3 = sha256_schedule_shani(w3, w0, w1, w2);
+                        sha256_rounds_shani(state0, state1, w3, g + 3);
+                    }
+
+                    state0 = _mm_add_epi32(state0, save0);
+                    state1 = _mm_add_epi32(state1, save1);
+
+                }
+
+                tmp = _mm_shuffle_epi32(state0, 0x1b); // FEBA
+                state1 = _mm_shuffle_epi32(state1, 0xb1); // DCHG
+                state0 = _mm_blend_epi16(tmp, state1, 0xf0); // DCBA
+                state1 = _mm_alignr_epi8(state1, tmp, 8); // HGFE
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+
+            }
+
+            bool cpu_has_sha_extensions() noexcept {
+                unsigned a = 0, b = 0, c = 0, d = 0;
+                if (__get_cpuid_max(0, nullptr) < 7)
+                    return false;
+                __get_cpuid(1, &a, &b, &c, &d);
+                bool ssse3 = (c & (1u << 9)) != 0;
+                bool sse41 = (c & (1u << 19)) != 0;
+                __cpuid_count(7, 0, a, b, c, d);
+                bool sha = (b & (1u << 29)) != 0;
+                return ssse3 && sse41 && sha;
+            }
+
+            bool has_sha_extensions() noexcept {
+                static const bool sha = cpu_has_sha_extensions();
+                return sha && (allowed_extensions.load(std::memory_order_relaxed) & Detail::hash_use_sha) != 0;
+            }
+
+        #else
+
+            bool has_sha_extensions() noexcept { return false; }
+
+        #endif
+
+        using Sha256Blocks = void (*)(uint32_t* state, const uint8_t* data, size_t blocks);
+
+        Sha256Blocks sha256_blocks() noexcept {
+            #ifdef RS_SCI_HASH_X86
+                return has_sha_extensions() ? sha256_blocks_shani : sha256_blocks_portable;
+            #else
+                return sha256_blocks_portable;
+            #endif
+        }
+
+        // The state is updated one block at a time; any incomplete block at
+        // the end of a call to add() is kept in the buffer until the next
+        // call. The length is only needed modulo 2^64 bytes; for SHA-512
+        // the top bits of the 128-bit bit count are taken from it.
+
+        template <typename Word, size_t BlockBytes>
+        struct Sha2Context {
+            Word state[8];
+            uint64_t length;
+            size_t buffered;
+            uint8_t buffer[BlockBytes];
+        };
+
+        using Sha256Context = Sha2Context<uint32_t, 64>;
+        using Sha512Context = Sha2Context<uint64_t, 128>;
+
+        template <typename Context, typename Blocks>
+        void sha2_update(Context& ctx, const uint8_t* ptr, size_t len, Blocks blocks) noexcept {
+            constexpr size_t block_bytes = sizeof(ctx.buffer);
+            ctx.length += len;
+            if (ctx.buffered > 0) {
+                size_t n = std::min(len, block_bytes - ctx.buffered);
+                std::memcpy(ctx.buffer + ctx.buffered, ptr, n);
+                ctx.buffered += n;
+                ptr += n;
+                len -= n;
+                if (ctx.buffered < block_bytes)
+                    return;
+                blocks(ctx.state, ctx.buffer, 1);
+                ctx.buffered = 0;
+            }
+            size_t n = len / block_bytes;
+            if (n > 0) {
+                blocks(ctx.state, ptr, n);
+                ptr += n * block_bytes;
+                len -= n * block_bytes;
+            }
+            if (len > 0) {
+                std::memcpy(ctx.buffer, ptr, len);
+                ctx.buffered = len;
+            }
+        }
+
+        // Append the padding and the length in bits, big endian, taking up
+        // the last 8 or 16 bytes of the final block
+
+        template <typename Context, typename Blocks>
+        void sha2_final(Context& ctx, Blocks blocks) noexcept {
+            constexpr size_t block_bytes = sizeof(ctx.buffer);
+            constexpr size_t length_bytes = block_bytes / 8;
+            uint64_t bit_length = ctx.length << 3;
+            uint64_t high_bits = ctx.length >> 61;
+            ctx.buffer[ctx.buffered++] = 0x80;
+            if (ctx.buffered > block_bytes - length_bytes) {
+                std::memset(ctx.buffer + ctx.buffered, 0, block_bytes - ctx.buffered);
+                blocks(ctx.state, ctx.buffer, 1);
+                ctx.buffered = 0;
+            }
+            std::memset(ctx.buffer + ctx.buffered, 0, block_bytes - ctx.buffered);
+            if constexpr (length_bytes == 16)
+                store_be64(high_bits, ctx.buffer + block_bytes - 16);
+            store_be64(bit_length, ctx.buffer + block_bytes - 8);
+            blocks(ctx.state, ctx.buffer, 1);
+        }
+
+        // Multi-buffer hashing with AVX2: each lane of a vector register
+        // works on a different message
+
+        #ifdef RS_SCI_HASH_X86
+
+            #define RS_SCI_AVX2_TARGET __attribute__((target("avx2")))
+
+            constexpr size_t sha256_lanes = 8;
+
+            bool has_avx2() noexcept {
+                static const bool avx2 = __builtin_cpu_supports("avx2");
+                return avx2 && (allowed_extensions.load(std::memory_order_relaxed) & Detail::hash_use_avx2) != 0;
+            }
+
+            template <int N>
+            RS_SCI_AVX2_TARGET inline __m256i rotl64x4(__m256i x) noexcept {
+                return _mm256_or_si256(_mm256_slli_epi64(x, N), _mm256_srli_epi64(x, 64 - N));
+            }
+
+            template <int N>
+            RS_SCI_AVX2_TARGET inline __m256i rotr32x8(__m256i x) noexcept {
+                return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+            }
+
+            // The same as Detail::siprounds(), in four lanes. Rotation by 32
+            // bits is a shuffle.
+
+            RS_SCI_AVX2_TARGET inline void siprounds_avx2(int n, __m256i& v0, __m256i& v1, __m256i& v2, __m256i& v3) noexcept {
+                for (int i = 0; i < n; ++i) {
+                    v0 = _mm256_add_epi64(v0, v1);
+                    v1 = rotl64x4<13>(v1);
+                    v1 = _mm256_xor_si256(v1, v0);
+                    v0 = _mm256_shuffle_epi32(v0, 0xb1);
+                    v2 = _mm256_add_epi64(v2, v3);
+                    v3 = rotl64x4<16>(v3);
+                    v3 = _mm256_xor_si256(v3, v2);
+                    v0 = _mm256_add_epi64(v0, v3);
+                    v3 = rotl64x4<21>(v3);
+                    v3 = _mm256_xor_si256(v3, v0);
+                    v2 = _mm256_add_epi64(v2, v1);
+                    v1 = rotl64x4<17>(v1);
+                    v1 = _mm256_xor_si256(v1, v2);
+                    v2 = _mm256_shuffle_epi32(v2, 0xb1);
+                }
+            }
+
+            // The kernel for Detail::siphash_words_avx2()
+
+            RS_SCI_AVX2_TARGET void siphash_words_x4(int c, uint64_t (&v)[4][Detail::sip_lanes], const uint8_t* const* ptrs, size_t n) noexcept {
+                __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v[0]));
+                __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v[1]));
+                __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v[2]));
+                __m256i v3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v[3]));
+                for (size_t i = 0; i < 8 * n; i += 8) {
+                    __m256i m = _mm256_set_epi64x(int64_t(Detail::load_le64(ptrs[3] + i)), int64_t(Detail::load_le64(ptrs[2] + i)),
+                        int64_t(Detail::load_le64(ptrs[1] + i)), int64_t(Detail::load_le64(ptrs[0] + i)));
+                    v3 = _mm256_xor_si256(v3, m);
+                    siprounds_avx2(c, v0, v1, v2, v3);
+                    v0 = _mm256_xor_si256(v0, m);
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(v[0]), v0);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(v[1]), v1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(v[2]), v2);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(v[3]), v3);
+            }
+
+            // The same as sha256_round(), in eight lanes
+
+            RS_SCI_AVX2_TARGET inline void sha256_round_avx2(__m256i a, __m256i b, __m256i c, __m256i& d,
+                    __m256i e, __m256i f, __m256i g, __m256i& h, __m256i kw) noexcept {
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr32x8<6>(e), rotr32x8<11>(e)), rotr32x8<25>(e));
+                __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+                h = _mm256_add_epi32(_mm256_add_epi32(h, s1), _mm256_add_epi32(ch, kw));
+                d = _mm256_add_epi32(d, h);
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr32x8<2>(a), rotr32x8<13>(a)), rotr32x8<22>(a));
+                __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+                h = _mm256_add_epi32(h, _mm256_add_epi32(s0, maj));
+            }
+
+            // Round constant plus message word, for round t
+
+            RS_SCI_AVX2_TARGET inline __m256i sha256_kw_avx2(const __m256i* w, int t) noexcept {
+                return _mm256_add_epi32(w[t & 15], _mm256_set1_epi32(int(sha256_k[t])));
+            }
+
+            // One block from each of eight messages, with the state stored as
+            // one vector per variable
+
+            RS_SCI_AVX2_TARGET void sha256_block_avx2(__m256i* state, const uint8_t* const* blocks) noexcept {
+
+                __m256i w[16];
+
+                for (int i = 0; i < 16; ++i)
+                    w[i] = _mm256_set_epi32(int(load_be32(blocks[7] + 4 * i)), int(load_be32(blocks[6] + 4 * i)),
+                        int(load_be32(blocks[5] + 4 * i)), int(load_be32(blocks[4] + 4 * i)),
+                        int(load_be32(blocks[3] + 4 * i)), int(load_be32(blocks[2] + 4 * i)),
+                        int(load_be32(blocks[1] + 4 * i)), int(load_be32(blocks[0] + 4 * i)));
+
+                __m256i a = state[0], b = state[1], c = state[2], d = state[3],
+                    e = state[4], f = state[5], g = state[6], h = state[7];
+
+                for (int i = 0; i < 64; i += 8) {
+                    if (i >= 16) {
+                        for (int j = i; j < i + 8; ++j) {
+                            __m256i x = w[(j + 1) & 15];
+                            __m256i y = w[(j + 14) & 15];
+                            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr32x8<7>(x), rotr32x8<18>(x)), _mm256_srli_epi32(x, 3));
+                            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr32x8<17>(y), rotr32x8<19>(y)), _mm256_srli_epi32(y, 10));
+                            w[j & 15] = _mm256_add_epi32(_mm256_add_epi32(w[j & 15], s0), _mm256_add_epi32(w[(j + 9) & 15], s1));
+                        }
+                    }
+                    sha256_round_avx2(a, b, c, d, e, f, g, h, sha256_kw_avx2(w, i));
+                    sha256_round_avx2(h, a, b, c, d, e, f, g, sha256_kw_avx2(w, i + 1));
+                    sha256_round_avx2(g, h, a, b, c, d, e, f, sha256_kw_avx2(w, i + 2));
+                    sha256_round_avx2(f, g, h, a, b, c, d, e, sha256_kw_avx2(w, i + 3));
+                    sha256_round_avx2(e, f, g, h, a, b, c, d, sha256_kw_avx2(w, i + 4));
+                    sha256_round_avx2(d, e, f, g, h, a, b, c, sha256_kw_avx2(w, i + 5));
+                    sha256_round_avx2(c, d, e, f, g, h, a, b, sha256_kw_avx2(w, i + 6));
+                    sha256_round_avx2(b, c, d, e, f, g, h, a, sha256_kw_avx2(w, i + 7));
+                }
+
+                state[0] = _mm256_add_epi32(state[0], a);
+                state[1] = _mm256_add_epi32(state[1], b);
+                state[2] = _mm256_add_epi32(state[2], c);
+                state[3] = _mm256_add_epi32(state[3], d);
+                state[4] = _mm256_add_epi32(state[4], e);
+                state[5] = _mm256_add_epi32(state[5], f);
+                state[6] = _mm256_add_epi32(state[6], g);
+                state[7] = _mm256_add_epi32(state[7], h);
+
+            }
+
+            // Any number of messages, eight at a time. Each lane works
+            // through one message, block by block, reading the padded tail of
+            // the message from a separate buffer; when it finishes, its digest
+            // is written out and the lane starts on the next message. Once
+            // the messages run out, idle lanes hash a dummy block, and their
+            // results are discarded.
+
+            RS_SCI_AVX2_TARGET void sha256_messages_avx2(const void* const* ptrs, const size_t* lens,
+                    size_t count, SHA256::digest_type* out) noexcept {
+
+                struct lane_type {
+                    const uint8_t* data;
+                    size_t index;
+                    size_t block;
+                    size_t full_blocks;
+                    size_t total_blocks;
+                    uint8_t tail[128];
+                };
+
+                lane_type lanes[sha256_lanes];
+                alignas(32) uint32_t words[8][sha256_lanes]; // [word][lane]
+                size_t next = 0;
+                size_t active = 0;
+
+                auto start = [&] (size_t i) {
+                    auto& lane = lanes[i];
+                    if (next == count) {
+                        lane.data = nullptr;
+                        return;
+                    }
+                    lane.index = next++;
+                    lane.data = static_cast<const uint8_t*>(ptrs[lane.index]);
+                    size_t len = lens[lane.index];
+                    size_t rest = len % 64;
+                    size_t tail_bytes = rest + 9 <= 64 ? 64 : 128;
+                    lane.block = 0;
+                    lane.full_blocks = len / 64;
+                    lane.total_blocks = lane.full_blocks + tail_bytes / 64;
+                    std::memcpy(lane.tail, lane.data + 64 * lane.full_blocks, rest);
+                    lane.tail[rest] = 0x80;
+                    std::memset(lane.tail + rest + 1, 0, tail_bytes - rest - 9);
+                    store_be64(uint64_t(len) << 3, lane.tail + tail_bytes - 8);
+                    for (int j = 0; j < 8; ++j)
+                        words[j][i] = sha256_h[j];
+                    ++active;
+                };
+
+                for (size_t i = 0; i < sha256_lanes; ++i)
+                    start(i);
+
+                __m256i state[8];
+                for (int j = 0; j < 8; ++j)
+                    state[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[j]));
+
+                while (active > 0) {
+
+                    const uint8_t* blocks[sha256_lanes];
+                    bool any_done = false;
+
+                    for (size_t i = 0; i < sha256_lanes; ++i) {
+                        auto& lane = lanes[i];
+                        if (lane.data == nullptr)
+                            blocks[i] = lane.tail;
+                        else if (lane.block < lane.full_blocks)
+                            blocks[i] = lane.data + 64 * lane.block;
+                        else
+                            blocks[i] = lane.tail + 64 * (lane.block - lane.full_blocks);
+                    }
+
+                    sha256_block_avx2(state, blocks);
+
+                    for (auto& lane: lanes)
+                        if (lane.data != nullptr && ++lane.block == lane.total_blocks)
+                            any_done = true;
+
+                    if (any_done) {
+                        for (int j = 0; j < 8; ++j)
+                            _mm256_store_si256(reinterpret_cast<__m256i*>(words[j]), state[j]);
+                        for (size_t i = 0; i < sha256_lanes; ++i) {
+                            auto& lane = lanes[i];
+                            if (lane.data != nullptr && lane.block == lane.total_blocks) {
+                                for (int j = 0; j < 8; ++j)
+                                    store_be32(words[j][i], out[lane.index].data() + 4 * j);
+                                --active;
+                                start(i);
+                            }
+                        }
+                        for (int j = 0; j < 8; ++j)
+                            state[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[j]));
+                    }
+
+                }
+
+            }
+
+        #endif
+
+        // Bulk hash
+
+        // Short inputs are mixed with a 64x64 to 128 bit multiply per 16
+        // bytes, following wyhash. Long inputs are spread over eight 64-bit
+        // accumulators, following XXH3: each 64-byte stripe adds a 32x32 to
+        // 64 bit product of key-mixed data into each accumulator, and every
+        // 16 stripes the accumulators are scrambled. The vector code does
+        // exactly the same arithmetic as the scalar code.
+
+        constexpr uint64_t bulk_p0 = 0xa076'1d64'78bd'642full;
+        constexpr uint64_t bulk_p1 = 0xe703'7ed1'a0b4'28dbull;
+        constexpr uint64_t bulk_p2 = 0x8ebc'6af0'9c88'c6e3ull;
+        constexpr uint64_t bulk_p3 = 0x5899'65cc'7537'4cc3ull;
+        constexpr uint64_t bulk_scramble = 0x9e37'79b1ull;
+        constexpr size_t bulk_short = 16;
+        constexpr size_t bulk_medium = 256;
+        constexpr size_t bulk_lanes = 8;
+        constexpr size_t bulk_stripe = 64;
+        constexpr size_t bulk_stripes_per_block = 16;
+        constexpr size_t bulk_block = bulk_stripe * bulk_stripes_per_block;
+
+        // Key layout: stripe i of a block uses words i to i+7, the final
+        // stripe uses words 23-30, the scramble uses words 32-39, and the
+        // two 64-bit merges use words 40-47 and 48-55
+
+        constexpr size_t bulk_last_key = 23;
+        constexpr size_t bulk_scramble_key = 32;
+        constexpr size_t bulk_merge_key = 40;
+        constexpr size_t bulk_merge_key2 = 48;
+        constexpr size_t bulk_secret_words = 56;
+
+        constexpr std::array<uint64_t, bulk_secret_words> make_bulk_secret() noexcept {
+            std::array<uint64_t, bulk_secret_words> secret = {};
+            uint64_t x = 0x243f'6a88'85a3'08d3ull; // Digits of pi
+            for (auto& s: secret) {
+                x += 0x9e37'79b9'7f4a'7c15ull;
+                uint64_t z = x;
+                z = (z ^ (z >> 30)) * 0xbf58'476d'1ce4'e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d0'49bb'1331'11ebull;
+                s = z ^ (z >> 31);
+            }
+            return secret;
+        }
+
+        constexpr std::array<uint64_t, bulk_secret_words> bulk_secret = make_bulk_secret();
+
+        // Full 128-bit product, returned in place as (low, high)
+
+        constexpr void bulk_mum(uint64_t& a, uint64_t& b) noexcept {
+            #ifdef __SIZEOF_INT128__
+                __extension__ using uint128 = unsigned __int128;
+                uint128 r = uint128(a) * b;
+                a = uint64_t(r);
+                b = uint64_t(r >> 64);
+            #else
+                uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+                uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+                uint64_t t = hl + (ll >> 32);
+                uint64_t u = lh + uint32_t(t);
+                a = (u << 32) | uint32_t(ll);
+                b = hh + (t >> 32) + (u >> 32);
+            #endif
+        }
+
+        constexpr uint64_t bulk_mix(uint64_t a, uint64_t b) noexcept {
+            bulk_mum(a, b);
+            return a ^ b;
+        }
+
+        uint64_t bulk_avalanche(uint64_t h) noexcept {
+            h ^= h >> 37;
+            h *= 0x1656'6791'9e37'79f9ull;
+            h ^= h >> 32;
+            return h;
+        }
+
+        // Inputs up to 256 bytes are reduced to two words, plus the mixed
+        // seed
+
+        void bulk_reduce(const uint8_t* ptr, size_t len, uint64_t& seed, uint64_t& a, uint64_t& b) noexcept {
+
+            if (len <= bulk_short) {
+
+                if (len >= 4) {
+                    size_t d = (len >> 3) << 2;
+                    a = (uint64_t(Detail::load_le32(ptr)) << 32) | Detail::load_le32(ptr + d);
+                    b = (uint64_t(Detail::load_le32(ptr + len - 4)) << 32) | Detail::load_le32(ptr + len - 4 - d);
+                } else if (len > 0) {
+                    a = (uint64_t(ptr[0]) << 16) | (uint64_t(ptr[len >> 1]) << 8) | ptr[len - 1];
+                    b = 0;
+                } else {
+                    a = b = 0;
+                }
+
+            } else {
+
+                size_t i = len;
+                uint64_t x = seed, y = seed;
+
+                for (; i > 32; i -= 32, ptr += 32) {
+                    x = bulk_mix(Detail::load_le64(ptr) ^ bulk_p1, Detail::load_le64(ptr + 8) ^ x);
+                    y = bulk_mix(Detail::load_le64(ptr + 16) ^ bulk_p2, Detail::load_le64(ptr + 24) ^ y);
+                }
+
+                if (i > 16) {
+                    x = bulk_mix(Detail::load_le64(ptr) ^ bulk_p1, Detail::load_le64(ptr + 8) ^ x);
+                    ptr += 16;
+                    i -= 16;
+                }
+
+                seed = x ^ y;
+                a = Detail::load_le64(ptr + i - 16);
+                b = Detail::load_le64(ptr + i - 8);
+
+            }
+
+            a ^= bulk_p1;
+            b ^= seed;
+            bulk_mum(a, b);
+
+        }
+
+        // Long inputs, scalar version
+
+        void bulk_stripe_scalar(uint64_t* acc, const uint8_t* ptr, const uint64_t* key) noexcept {
+            for (size_t j = 0; j < bulk_lanes; ++j) {
+                uint64_t d = Detail::load_le64(ptr + 8 * j);
+                uint64_t k = d ^ key[j];
+                acc[j ^ 1] += d;
+                acc[j] += (k & 0xffff'ffffull) * (k >> 32);
+            }
+        }
+
+        void bulk_scramble_scalar(uint64_t* acc, const uint64_t* key) noexcept {
+            for (size_t j = 0; j < bulk_lanes; ++j) {
+                acc[j] ^= acc[j] >> 47;
+                acc[j] ^= key[j];
+                acc[j] *= bulk_scramble;
+            }
+        }
+
+        void bulk_long_scalar(uint64_t* acc, const uint8_t* ptr, size_t len, const uint64_t* key) noexcept {
+            size_t blocks = (len - 1) / bulk_block;
+            for (size_t i = 0; i < blocks; ++i, ptr += bulk_block) {
+                for (size_t s = 0; s < bulk_stripes_per_block; ++s)
+                    bulk_stripe_scalar(acc, ptr + s * bulk_stripe, key + s);
+                bulk_scramble_scalar(acc, key + bulk_scramble_key);
+            }
+            size_t rest = len - blocks * bulk_block;
+            size_t stripes = (rest - 1) / bulk_stripe;
+            for (size_t s = 0; s < stripes; ++s)
+                bulk_stripe_scalar(acc, ptr + s * bulk_stripe, key + s);
+            bulk_stripe_scalar(acc, ptr + rest - bulk_stripe, key + bulk_last_key);
+        }
+
+        // Long inputs, AVX2 version. Swapping adjacent 64-bit lanes is a
+        // 32-bit shuffle, and the 64x32 bit scramble multiply is built from
+        // two 32x32 bit products.
+
+        #ifdef RS_SCI_HASH_X86
+
+            RS_SCI_AVX2_TARGET inline void bulk_stripe_avx2(__m256i* acc, const uint8_t* ptr, const uint64_t* key) noexcept {
+                for (int j = 0; j < 2; ++j) {
+                    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + 32 * j));
+                    __m256i k = _mm256_xor_si256(d, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + 4 * j)));
+                    __m256i p = _mm256_mul_epu32(k, _mm256_srli_epi64(k, 32));
+                    acc[j] = _mm256_add_epi64(acc[j], _mm256_shuffle_epi32(d, 0x4e));
+                    acc[j] = _mm256_add_epi64(acc[j], p);
+                }
+            }
+
+            RS_SCI_AVX2_TARGET inline void bulk_scramble_avx2(__m256i* acc, const uint64_t* key) noexcept {
+                const __m256i prime = _mm256_set1_epi64x(int64_t(bulk_scramble));
+                for (int j = 0; j < 2; ++j) {
+                    __m256i a = acc[j];
+                    a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+                    a = _mm256_xor_si256(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + 4 * j)));
+                    __m256i low = _mm256_mul_epu32(a, prime);
+                    __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+                    acc[j] = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+                }
+            }
+
+            RS_SCI_AVX2_TARGET void bulk_long_avx2(uint64_t* acc, const uint8_t* ptr, size_t len, const uint64_t* key) noexcept {
+                __m256i vacc[2] = {
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + 4)),
+                };
+                size_t blocks = (len - 1) / bulk_block;
+                for (size_t i = 0; i < blocks; ++i, ptr += bulk_block) {
+                    for (size_t s = 0; s < bulk_stripes_per_block; ++s)
+                        bulk_stripe_avx2(vacc, ptr + s * bulk_stripe, key + s);
+                    bulk_scramble_avx2(vacc, key + bulk_scramble_key);
+                }
+                size_t rest = len - blocks * bulk_block;
+                size_t stripes = (rest - 1) / bulk_stripe;
+                for (size_t s = 0; s < stripes; ++s)
+                    bulk_stripe_avx2(vacc, ptr + s * bulk_stripe, key + s);
+                bulk_stripe_avx2(vacc, ptr + rest - bulk_stripe, key + bulk_last_key);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), vacc[0]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 4), vacc[1]);
+            }
+
+        #endif
+
+        // Returns the avalanched sum of the merged accumulators, with either
+        // set of merge keys
+
+        uint64_t bulk_merge(const uint64_t* acc, const uint64_t* key, uint64_t start) noexcept {
+            uint64_t h = start;
+            for (size_t j = 0; j < bulk_lanes; j += 2)
+                h += bulk_mix(acc[j] ^ key[j], acc[j + 1] ^ key[j + 1]);
+            return bulk_avalanche(h);
+        }
+
+        void bulk_long(const uint8_t* ptr, size_t len, uint64_t seed, uint64_t* acc, uint64_t* key) noexcept {
+
+            static constexpr uint64_t acc_init[bulk_lanes] = {
+                0x0000'0000'c2b2'ae3dull, 0x9e37'79b1'85eb'ca87ull, 0xc2b2'ae3d'27d4'eb4full, 0x1656'6791'9e37'79f9ull,
+                0x85eb'ca77'c2b2'ae63ull, 0x0000'0000'85eb'ca77ull, 0x27d4'eb2f'1656'67c5ull, 0x0000'0000'9e37'79b1ull,
+            };
+
+            std::copy(acc_init, acc_init + bulk_lanes, acc);
+
+            for (size_t i = 0; i < bulk_secret_words; i += 2) {
+                key[i] = bulk_secret[i] + seed;
+                key[i + 1] = bulk_secret[i + 1] - seed;
+            }
+
+            #ifdef RS_SCI_HASH_X86
+                if (has_avx2()) {
+                    bulk_long_avx2(acc, ptr, len, key);
+                    return;
+                }
+            #endif
+
+            bulk_long_scalar(acc, ptr, len, key);
+
+        }
+
+        // The default seed's mixed value is precomputed
+
+        uint64_t bulk_seed(uint64_t seed) noexcept {
+            static constexpr uint64_t zero = bulk_mix(bulk_p0, bulk_p1);
+            return seed == 0 ? zero : seed ^ bulk_mix(seed ^ bulk_p0, bulk_p1);
+        }
+
+    }
+
     // Cryptographic hash functions
 
     #if defined(__APPLE__)
@@ -22,6 +856,7 @@ namespace RS::Sci {
         #define HASH_INIT(unix_function_prefix, windows_function_suffix)  CC_ ## unix_function_prefix ## _Init(ctx);
         #define HASH_UPDATE(unix_function_prefix)                         CC_ ## unix_function_prefix ## _Update(ctx, ptr, uint32_t(len));
         #define HASH_FINAL(unix_function_prefix)                          CC_ ## unix_function_prefix ## _Final(byte_data(), ctx);
+        #define HASH_ABORT                                                (void)ctx;
 
     #elif defined(_XOPEN_SOURCE)
 
@@ -29,6 +864,7 @@ namespace RS::Sci {
         #define HASH_INIT(unix_function_prefix, windows_function_suffix)  unix_function_prefix ## _Init(ctx);
         #define HASH_UPDATE(unix_function_prefix)                         unix_function_prefix ## _Update(ctx, ptr, uint32_t(len));
         #define HASH_FINAL(unix_function_prefix)                          unix_function_prefix ## _Final(byte_data(), ctx);
+        #define HASH_ABORT                                                (void)ctx;
 
     #else
 
@@ -43,57 +879,188 @@ namespace RS::Sci {
             CryptAcquireContextW(&ctx->hcprov, nullptr, MS_ENH_RSA_AES_PROV, PROV_RSA_AES, CRYPT_SILENT | CRYPT_VERIFYCONTEXT); \
             CryptCreateHash(ctx->hcprov, CALG_ ## windows_function_suffix, 0, 0, &ctx->hchash);
         #define HASH_UPDATE(unix_function_prefix) \
-            CryptHashData(ctx->hchash, static_cast<const unsigned char*>(ptr), DWORD(len), 0);
+            CryptHashData(ctx->hchash, ptr, DWORD(len), 0);
         #define HASH_FINAL(unix_function_prefix) \
             ctx->hashlen = DWORD(bytes()); \
             CryptGetHashParam(ctx->hchash, HP_HASHVAL, byte_data(), &ctx->hashlen, 0); \
             CryptDestroyHash(ctx->hchash); \
             CryptReleaseContext(ctx->hcprov, 0);
+        #define HASH_ABORT \
+            CryptDestroyHash(ctx->hchash); \
+            CryptReleaseContext(ctx->hcprov, 0);
 
     #endif
 
+    // Each platform context is a plain C struct, constructed in place in
+    // the buffer in the base class. Only the Windows context holds handles
+    // that need to be released if it is abandoned.
+
     #define IMPLEMENT_CRYPTOGRAPHIC_HASH(ClassName, unix_function_prefix, unix_context_prefix, windows_function_suffix) \
-        void ClassName::do_add(const void* ptr, size_t len) { \
+        void ClassName::do_init() noexcept { \
+            using context_type = HASH_CONTEXT(unix_function_prefix, unix_context_prefix); \
+            static_assert(sizeof(context_type) <= context_size); \
+            static_assert(alignof(context_type) <= alignof(std::max_align_t)); \
+            auto ctx = new (context()) context_type; \
+            HASH_INIT(unix_function_prefix, windows_function_suffix) \
+        } \
+        void ClassName::do_add(const void* data, size_t size) { \
             using context_type = HASH_CONTEXT(unix_function_prefix, unix_context_prefix); \
-            auto ctx = static_cast<context_type*>(anon_ctx_); \
-            if (! anon_ctx_) { \
-                anon_ctx_ = ctx = new context_type; \
-                HASH_INIT(unix_function_prefix, windows_function_suffix) \
+            auto ctx = static_cast<context_type*>(context()); \
+            auto ptr = static_cast<const unsigned char*>(data); \
+            for (size_t len = 0; size > 0; ptr += len, size -= len) { \
+                len = std::min(size, max_native_update); \
+                HASH_UPDATE(unix_function_prefix) \
             } \
-            HASH_UPDATE(unix_function_prefix) \
         } \
         void ClassName::do_final() noexcept { \
             using context_type = HASH_CONTEXT(unix_function_prefix, unix_context_prefix); \
-            if (anon_ctx_) { \
-                auto ctx = static_cast<context_type*>(anon_ctx_); \
-                HASH_FINAL(unix_function_prefix) \
-                delete ctx; \
-                anon_ctx_ = nullptr; \
-            } \
+            auto ctx = static_cast<context_type*>(context()); \
+            HASH_FINAL(unix_function_prefix) \
+        } \
+        void ClassName::do_abort() noexcept { \
+            using context_type = HASH_CONTEXT(unix_function_prefix, unix_context_prefix); \
+            auto ctx = static_cast<context_type*>(context()); \
+            HASH_ABORT \
         }
 
-        void MD5::do_add(const void* ptr, size_t len) {
-            using context_type = HASH_CONTEXT(MD5, MD5);
-            auto ctx = static_cast<context_type*>(anon_ctx_);
-            if (! anon_ctx_) {
-                anon_ctx_ = ctx = new context_type;
-                HASH_INIT(MD5, MD5)
-            }
-            HASH_UPDATE(MD5)
+    IMPLEMENT_CRYPTOGRAPHIC_HASH(MD5, MD5, MD5, MD5)
+    IMPLEMENT_CRYPTOGRAPHIC_HASH(SHA1, SHA1, SHA, SHA1)
+
+    // SHA-256 and SHA-512 are implemented here, independent of the platform
+
+    bool SHA256::hardware_accelerated() noexcept {
+        return sha256_blocks() != sha256_blocks_portable;
+    }
+
+    void SHA256::do_init() noexcept {
+        static_assert(sizeof(Sha256Context) <= context_size);
+        auto ctx = new (context()) Sha256Context;
+        std::memcpy(ctx->state, sha256_h, sizeof(sha256_h));
+        ctx->length = 0;
+        ctx->buffered = 0;
+    }
+
+    void SHA256::do_add(const void* ptr, size_t len) {
+        auto ctx = static_cast<Sha256Context*>(context());
+        sha2_update(*ctx, static_cast<const uint8_t*>(ptr), len, sha256_blocks());
+    }
+
+    void SHA256::do_final() noexcept {
+        auto ctx = static_cast<Sha256Context*>(context());
+        sha2_final(*ctx, sha256_blocks());
+        for (int i = 0; i < 8; ++i)
+            store_be32(ctx->state[i], byte_data() + 4 * i);
+    }
+
+    void SHA512::do_init() noexcept {
+        static_assert(sizeof(Sha512Context) <= context_size);
+        auto ctx = new (context()) Sha512Context;
+        std::memcpy(ctx->state, sha512_h, sizeof(sha512_h));
+        ctx->length = 0;
+        ctx->buffered = 0;
+    }
+
+    void SHA512::do_add(const void* ptr, size_t len) {
+        auto ctx = static_cast<Sha512Context*>(context());
+        sha2_update(*ctx, static_cast<const uint8_t*>(ptr), len, sha512_blocks_portable);
+    }
+
+    void SHA512::do_final() noexcept {
+        auto ctx = static_cast<Sha512Context*>(context());
+        sha2_final(*ctx, sha512_blocks_portable);
+        for (int i = 0; i < 8; ++i)
+            store_be64(ctx->state[i], byte_data() + 8 * i);
+    }
+
+    // Bulk hash
+
+    uint64_t bulk_hash64(const void* ptr, size_t len, uint64_t seed) noexcept {
+
+        auto bptr = static_cast<const uint8_t*>(ptr);
+
+        if (len <= bulk_medium) {
+            uint64_t a, b;
+            seed = bulk_seed(seed);
+            bulk_reduce(bptr, len, seed, a, b);
+            return bulk_mix(a ^ bulk_p0 ^ len, b ^ bulk_p1);
         }
-        void MD5::do_final() noexcept {
-            using context_type = HASH_CONTEXT(MD5, MD5);
-            if (anon_ctx_) {
-                auto ctx = static_cast<context_type*>(anon_ctx_);
-                HASH_FINAL(MD5)
-                delete ctx;
-                anon_ctx_ = nullptr;
-            }
+
+        uint64_t acc[bulk_lanes];
+        uint64_t key[bulk_secret_words];
+        bulk_long(bptr, len, seed, acc, key);
+
+        return bulk_merge(acc, key + bulk_merge_key, len * bulk_p0);
+
+    }
+
+    Hash128 bulk_hash128(const void* ptr, size_t len, uint64_t seed) noexcept {
+
+        auto bptr = static_cast<const uint8_t*>(ptr);
+
+        if (len <= bulk_medium) {
+            uint64_t a, b;
+            seed = bulk_seed(seed);
+            bulk_reduce(bptr, len, seed, a, b);
+            return {{bulk_mix(a ^ bulk_p0 ^ len, b ^ bulk_p1), bulk_mix(a ^ bulk_p2, b ^ bulk_p3 ^ len)}};
         }
 
-    // IMPLEMENT_CRYPTOGRAPHIC_HASH(MD5, MD5, MD5, MD5)
-    IMPLEMENT_CRYPTOGRAPHIC_HASH(SHA1, SHA1, SHA, SHA1)
-    IMPLEMENT_CRYPTOGRAPHIC_HASH(SHA256, SHA256, SHA256, SHA_256)
-    IMPLEMENT_CRYPTOGRAPHIC_HASH(SHA512, SHA512, SHA512, SHA_512)
+        uint64_t acc[bulk_lanes];
+        uint64_t key[bulk_secret_words];
+        bulk_long(bptr, len, seed, acc, key);
+
+        return {{bulk_merge(acc, key + bulk_merge_key, len * bulk_p0),
+            bulk_merge(acc, key + bulk_merge_key2, ~ (len * bulk_p1))}};
+
+    }
+
+    // Instruction set selection
+
+    unsigned Detail::hash_extensions() noexcept {
+        return allowed_extensions.load(std::memory_order_relaxed);
+    }
+
+    void Detail::set_hash_extensions(unsigned mask) noexcept {
+        allowed_extensions.store(mask & hash_use_all, std::memory_order_relaxed);
+    }
+
+    // Batch hashing
+
+    bool Detail::siphash_avx2() noexcept {
+        #ifdef RS_SCI_HASH_X86
+            return has_avx2();
+        #else
+            return false;
+        #endif
+    }
+
+    void Detail::siphash_words_avx2(int c, uint64_t (&v)[4][sip_lanes], const uint8_t* const* ptrs, size_t n) noexcept {
+        #ifdef RS_SCI_HASH_X86
+            siphash_words_x4(c, v, ptrs, n);
+        #else
+            (void)c;
+            (void)v;
+            (void)ptrs;
+            (void)n;
+        #endif
+    }
+
+    void SHA256::hash_batch(const void* const* ptrs, const size_t* lens, size_t count, digest_type* out) {
+
+        // The SHA extensions are faster than AVX2 multi-buffer hashing on
+        // the processors that have both
+
+        #ifdef RS_SCI_HASH_X86
+            if (has_avx2() && ! has_sha_extensions() && count >= sha256_lanes) {
+                sha256_messages_avx2(ptrs, lens, count, out);
+                return;
+            }
+        #endif
+
+        SHA256 hash;
+
+        for (size_t i = 0; i < count; ++i)
+            hash(ptrs[i], lens[i], out[i]);
+
+    }
 
 }
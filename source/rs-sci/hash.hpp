@@ -1,10 +1,15 @@
 #pragma once
 
 #include "rs-tl/binary.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 namespace RS::Sci {
 
@@ -48,92 +53,352 @@ namespace RS::Sci {
         return h;
     }
 
-    // SipHash-2-4-64 by Jean-Philippe Aumasson and Daniel J. Bernstein
-    // https://github.com/veorq/SipHash
+    // Fast non-cryptographic hash for blocks of bytes, in the style of
+    // wyhash and XXH3. The result depends only on the bytes, the length and
+    // the seed, never on the platform or the instruction set used.
+
+    using Hash128 = std::array<uint64_t, 2>; // Low, high
+
+    uint64_t bulk_hash64(const void* ptr, size_t len, uint64_t seed = 0) noexcept;
+    Hash128 bulk_hash128(const void* ptr, size_t len, uint64_t seed = 0) noexcept;
+
+    namespace Detail {
+
+        template <typename T, typename = void>
+        struct HasDataAndSize: std::false_type {};
+
+        template <typename T>
+        struct HasDataAndSize<T, std::void_t<decltype(std::data(std::declval<const T&>())),
+            decltype(std::size(std::declval<const T&>()))>>: std::true_type {};
+
+        // The bytes of a contiguous container of plain values, or of a
+        // plain value, where every bit of the representation is part of
+        // the value
+
+        template <typename T>
+        std::pair<const void*, size_t> bulk_hash_bytes(const T& t) noexcept {
+            if constexpr (HasDataAndSize<T>::value) {
+                using V = std::remove_cv_t<std::remove_pointer_t<decltype(std::data(t))>>;
+                static_assert(std::has_unique_object_representations_v<V>, "Container elements are not suitable for byte hashing");
+                return {std::data(t), std::size(t) * sizeof(V)};
+            } else {
+                static_assert(std::has_unique_object_representations_v<T>, "Type is not suitable for byte hashing");
+                return {&t, sizeof(T)};
+            }
+        }
 
-    class SipHash {
+    }
 
+    template <typename T>
+    class BulkHasher {
     public:
+        BulkHasher() = default;
+        explicit BulkHasher(uint64_t seed) noexcept: seed_(seed) {}
+        size_t operator()(const T& t) const noexcept {
+            auto [ptr, len] = Detail::bulk_hash_bytes(t);
+            return size_t(bulk_hash64(ptr, len, seed_));
+        }
+        uint64_t seed() const noexcept { return seed_; }
+    private:
+        uint64_t seed_ = 0;
+    };
 
-        using result_type = uint64_t;
+    // SipHash-c-d by Jean-Philippe Aumasson and Daniel J. Bernstein
+    // https://github.com/veorq/SipHash
 
-        constexpr SipHash() noexcept {}
-        constexpr SipHash(uint64_t key0, uint64_t key1) noexcept: key0_(key0), key1_(key1) {}
+    namespace Detail {
 
-        constexpr uint64_t operator()(const void* ptr, size_t len) const noexcept {
+        // Little endian loads; compilers turn these into a single load on
+        // little endian hosts
 
-            uint64_t v0 = 0x736f'6d65'7073'6575ull;
-            uint64_t v1 = 0x646f'7261'6e64'6f6dull;
-            uint64_t v2 = 0x6c79'6765'6e65'7261ull;
-            uint64_t v3 = 0x7465'6462'7974'6573ull;
+        constexpr uint32_t load_le32(const uint8_t* ptr) noexcept {
+            return uint32_t(ptr[0]) | (uint32_t(ptr[1]) << 8) | (uint32_t(ptr[2]) << 16) | (uint32_t(ptr[3]) << 24);
+        }
+
+        constexpr uint64_t load_le64(const uint8_t* ptr) noexcept {
+            return uint64_t(load_le32(ptr)) | (uint64_t(load_le32(ptr + 4)) << 32);
+        }
 
-            v0 ^= key0_;
-            v1 ^= key1_;
-            v2 ^= key0_;
-            v3 ^= key1_;
+        constexpr uint64_t sip_iv[4] = {
+            0x736f'6d65'7073'6575ull,
+            0x646f'7261'6e64'6f6dull,
+            0x6c79'6765'6e65'7261ull,
+            0x7465'6462'7974'6573ull,
+        };
 
-            auto bptr = static_cast<const uint8_t*>(ptr);
-            auto end = bptr + (len - len % sizeof(uint64_t));
+        template <int N>
+        constexpr void siprounds(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) noexcept {
+            for (int i = 0; i < N; ++i) {
+                v0 += v1;
+                v1 = TL::rotl(v1, 13);
+                v1 ^= v0;
+                v0 = TL::rotl(v0, 32);
+                v2 += v3;
+                v3 = TL::rotl(v3, 16);
+                v3 ^= v2;
+                v0 += v3;
+                v3 = TL::rotl(v3, 21);
+                v3 ^= v0;
+                v2 += v1;
+                v1 = TL::rotl(v1, 17);
+                v1 ^= v2;
+                v2 = TL::rotl(v2, 32);
+            }
+        }
+
+        // Continue from a state after some whole words have been processed,
+        // with the remaining bytes of the message, and its total length
+
+        template <int C, int D>
+        constexpr uint64_t siphash_finish(uint64_t v0, uint64_t v1, uint64_t v2, uint64_t v3,
+                const uint8_t* bptr, size_t rest, size_t len) noexcept {
+
+            auto end = bptr + (rest - rest % sizeof(uint64_t));
 
-            while (bptr != end) {
-                uint64_t m = 0;
-                for (int i = 0; i < 64; i += 8)
-                    m |= uint64_t(*bptr++) << i;
+            for (; bptr != end; bptr += sizeof(uint64_t)) {
+                uint64_t m = load_le64(bptr);
                 v3 ^= m;
-                siprounds(2, v0, v1, v2, v3);
+                siprounds<C>(v0, v1, v2, v3);
                 v0 ^= m;
             }
 
-            int left = int(len & 7);
+            int left = int(rest & 7);
             uint64_t b = uint64_t(len) << 56;
 
             for (int i = left - 1; i >= 0; --i)
                 b |= uint64_t(bptr[i]) << 8 * i;
 
             v3 ^= b;
-            siprounds(2, v0, v1, v2, v3);
+            siprounds<C>(v0, v1, v2, v3);
             v0 ^= b;
             v2 ^= 0xff;
-            siprounds(4, v0, v1, v2, v3);
+            siprounds<D>(v0, v1, v2, v3);
 
             return v0 ^ v1 ^ v2 ^ v3;
 
         }
 
+        // Multi-buffer SipHash with AVX2, in hash.cpp: advance each of four
+        // messages by n words, with the state stored as v[variable][lane],
+        // and c rounds per word. Only call this if siphash_avx2() is true.
+
+        constexpr size_t sip_lanes = 4;
+
+        bool siphash_avx2() noexcept;
+        void siphash_words_avx2(int c, uint64_t (&v)[4][sip_lanes], const uint8_t* const* ptrs, size_t n) noexcept;
+
+        // Four lanes, each working through one message at a time. All the
+        // lanes process as many words as the shortest remaining message has
+        // left; then any lane that has run out of whole words finishes its
+        // message, and starts on the next one. Idle lanes, once the messages
+        // run out, repeat another lane's words.
+
+        template <int C, int D>
+        void siphash_batch(uint64_t key0, uint64_t key1,
+                const void* const* ptrs, const size_t* lens, size_t count, uint64_t* out) noexcept {
+
+            const uint64_t iv[4] = {
+                sip_iv[0] ^ key0,
+                sip_iv[1] ^ key1,
+                sip_iv[2] ^ key0,
+                sip_iv[3] ^ key1,
+            };
+
+            if (count < sip_lanes || ! siphash_avx2()) {
+                for (size_t i = 0; i < count; ++i)
+                    out[i] = siphash_finish<C, D>(iv[0], iv[1], iv[2], iv[3], static_cast<const uint8_t*>(ptrs[i]), lens[i], lens[i]);
+                return;
+            }
+
+            const uint8_t* bptrs[sip_lanes];
+            size_t words[sip_lanes];
+            size_t index[sip_lanes];
+            uint64_t v[4][sip_lanes];
+            size_t next = 0;
+            size_t active = 0;
+
+            auto start = [&] (size_t j) {
+                if (next == count) {
+                    bptrs[j] = nullptr;
+                    words[j] = ~ size_t(0);
+                    return;
+                }
+                index[j] = next++;
+                bptrs[j] = static_cast<const uint8_t*>(ptrs[index[j]]);
+                words[j] = lens[index[j]] / 8;
+                for (int k = 0; k < 4; ++k)
+                    v[k][j] = iv[k];
+                ++active;
+            };
+
+            for (size_t j = 0; j < sip_lanes; ++j)
+                start(j);
+
+            while (active > 0) {
+                size_t n = *std::min_element(words, words + sip_lanes);
+                if (n > 0) {
+                    const uint8_t* live = *std::find_if(bptrs, bptrs + sip_lanes, [] (auto p) { return p != nullptr; });
+                    const uint8_t* step[sip_lanes];
+                    for (size_t j = 0; j < sip_lanes; ++j)
+                        step[j] = bptrs[j] == nullptr ? live : bptrs[j];
+                    siphash_words_avx2(C, v, step, n);
+                }
+                for (size_t j = 0; j < sip_lanes; ++j) {
+                    if (bptrs[j] == nullptr)
+                        continue;
+                    bptrs[j] += 8 * n;
+                    words[j] -= n;
+                    if (words[j] == 0) {
+                        size_t len = lens[index[j]];
+                        out[index[j]] = siphash_finish<C, D>(v[0][j], v[1][j], v[2][j], v[3][j], bptrs[j], len % 8, len);
+                        --active;
+                        start(j);
+                    }
+                }
+            }
+
+        }
+
+        // The optional instruction set extensions the hash functions may use,
+        // where the processor has them (all of them by default). The tests
+        // narrow this to check every code path on any machine. It can be
+        // changed at any time; every path gives the same results.
+
+        constexpr unsigned hash_use_avx2 = 1;
+        constexpr unsigned hash_use_sha = 2;
+        constexpr unsigned hash_use_all = hash_use_avx2 | hash_use_sha;
+
+        unsigned hash_extensions() noexcept;
+        void set_hash_extensions(unsigned mask) noexcept;
+
+    }
+
+    template <int C, int D>
+    class BasicSipHash {
+
+    public:
+
+        using result_type = uint64_t;
+
+        static constexpr int compression_rounds = C;
+        static constexpr int finalization_rounds = D;
+
+        constexpr BasicSipHash() noexcept {}
+        constexpr BasicSipHash(uint64_t key0, uint64_t key1) noexcept: key0_(key0), key1_(key1) {}
+
+        constexpr uint64_t operator()(const void* ptr, size_t len) const noexcept {
+            return Detail::siphash_finish<C, D>(Detail::sip_iv[0] ^ key0_, Detail::sip_iv[1] ^ key1_,
+                Detail::sip_iv[2] ^ key0_, Detail::sip_iv[3] ^ key1_, static_cast<const uint8_t*>(ptr), len, len);
+        }
+
+        void hash_batch(const void* const* ptrs, const size_t* lens, size_t count, uint64_t* out) const noexcept {
+            Detail::siphash_batch<C, D>(key0_, key1_, ptrs, lens, count, out);
+        }
+
     private:
 
         uint64_t key0_ = 0;
         uint64_t key1_ = 0;
 
-        static constexpr void siprounds(int n, uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) noexcept {
-            for (int i = 0; i < n; ++i) {
+    };
+
+    using SipHash = BasicSipHash<2, 4>;
+    using SipHash13 = BasicSipHash<1, 3>;
+
+    // HalfSipHash-c-d-32, the 32-bit version of SipHash, with a 64-bit key
+
+    template <int C, int D>
+    class BasicHalfSipHash {
+
+    public:
+
+        using result_type = uint32_t;
+
+        static constexpr int compression_rounds = C;
+        static constexpr int finalization_rounds = D;
+
+        constexpr BasicHalfSipHash() noexcept {}
+        constexpr BasicHalfSipHash(uint32_t key0, uint32_t key1) noexcept: key0_(key0), key1_(key1) {}
+
+        constexpr uint32_t operator()(const void* ptr, size_t len) const noexcept {
+
+            uint32_t v0 = key0_;
+            uint32_t v1 = key1_;
+            uint32_t v2 = 0x6c79'6765u ^ key0_;
+            uint32_t v3 = 0x7465'6462u ^ key1_;
+
+            auto bptr = static_cast<const uint8_t*>(ptr);
+            auto end = bptr + (len - len % sizeof(uint32_t));
+
+            for (; bptr != end; bptr += sizeof(uint32_t)) {
+                uint32_t m = Detail::load_le32(bptr);
+                v3 ^= m;
+                siprounds<C>(v0, v1, v2, v3);
+                v0 ^= m;
+            }
+
+            int left = int(len & 3);
+            uint32_t b = uint32_t(len) << 24;
+
+            for (int i = left - 1; i >= 0; --i)
+                b |= uint32_t(bptr[i]) << 8 * i;
+
+            v3 ^= b;
+            siprounds<C>(v0, v1, v2, v3);
+            v0 ^= b;
+            v2 ^= 0xff;
+            siprounds<D>(v0, v1, v2, v3);
+
+            return v1 ^ v3;
+
+        }
+
+    private:
+
+        uint32_t key0_ = 0;
+        uint32_t key1_ = 0;
+
+        template <int N>
+        static constexpr void siprounds(uint32_t& v0, uint32_t& v1, uint32_t& v2, uint32_t& v3) noexcept {
+            for (int i = 0; i < N; ++i) {
                 v0 += v1;
-                v1 = TL::rotl(v1, 13);
+                v1 = TL::rotl(v1, 5);
                 v1 ^= v0;
-                v0 = TL::rotl(v0, 32);
+                v0 = TL::rotl(v0, 16);
                 v2 += v3;
-                v3 = TL::rotl(v3, 16);
+                v3 = TL::rotl(v3, 8);
                 v3 ^= v2;
                 v0 += v3;
-                v3 = TL::rotl(v3, 21);
+                v3 = TL::rotl(v3, 7);
                 v3 ^= v0;
                 v2 += v1;
-                v1 = TL::rotl(v1, 17);
+                v1 = TL::rotl(v1, 13);
                 v1 ^= v2;
-                v2 = TL::rotl(v2, 32);
+                v2 = TL::rotl(v2, 16);
             }
         }
 
     };
 
+    using HalfSipHash = BasicHalfSipHash<2, 4>;
+    using HalfSipHash13 = BasicHalfSipHash<1, 3>;
+
     // Cryptographic hash functions
 
+    // The platform's hash context is constructed in place in a fixed size
+    // buffer, and the digest is held in a fixed size array, so hashing
+    // never allocates except when the result is returned as a string.
+    // Clearing or destroying an open hash abandons the context without
+    // finalizing it; the next add() initializes it again in place.
+
     class CryptographicHash {
 
     public:
 
         using result_type = std::string;
 
+        static constexpr size_t max_bytes = 64;
+
         virtual ~CryptographicHash() noexcept {}
         CryptographicHash(const CryptographicHash&) = delete;
         CryptographicHash(CryptographicHash&&) = delete;
@@ -145,62 +410,98 @@ namespace RS::Sci {
 
         size_t bits() const noexcept { return bits_; }
         size_t bytes() const noexcept { return bits_ / 8; }
-        void add(const void* ptr, size_t len) { do_add(ptr, len); }
-        void add(const std::string& str) { do_add(str.data(), str.size()); }
-        std::string get() { do_final(); return hash_; }
-        void clear() noexcept { do_final(); hash_.assign(bytes(), '\0'); }
+        void add(const void* ptr, size_t len) { open(); do_add(ptr, len); }
+        void add(const std::string& str) { add(str.data(), str.size()); }
+        std::string get() { close(); return std::string(reinterpret_cast<const char*>(hash_.data()), bytes()); }
+        void get(uint8_t* out) noexcept { close(); std::memcpy(out, hash_.data(), bytes()); }
+        void clear() noexcept { abort(); hash_.fill(0); }
 
     protected:
 
-        size_t bits_;
-        void* anon_ctx_;
-        std::string hash_;
+        static constexpr size_t context_size = 256;
 
-        explicit CryptographicHash(size_t b): bits_(b), anon_ctx_(nullptr), hash_(bytes(), '\0') {}
+        explicit CryptographicHash(size_t b) noexcept: bits_(b) {}
 
+        virtual void do_init() noexcept = 0;
         virtual void do_add(const void* ptr, size_t len) = 0;
         virtual void do_final() noexcept = 0;
+        virtual void do_abort() noexcept {}
+
+        void* context() noexcept { return context_; }
+        unsigned char* byte_data() noexcept { return hash_.data(); }
+        void close() noexcept { if (open_) { do_final(); open_ = false; } }
+        void abort() noexcept { if (open_) { do_abort(); open_ = false; } }
+
+    private:
 
-        auto byte_data() noexcept { return reinterpret_cast<unsigned char*>(hash_.data()); }
+        alignas(std::max_align_t) unsigned char context_[context_size];
+        std::array<uint8_t, max_bytes> hash_ = {};
+        size_t bits_;
+        bool open_ = false;
+
+        void open() noexcept { if (! open_) { do_init(); open_ = true; } }
 
     };
 
-    class MD5:
+    template <size_t Bits>
+    class BasicCryptographicHash:
     public CryptographicHash {
     public:
-        MD5(): CryptographicHash(128) {}
-        ~MD5() noexcept override { do_final(); }
+        static constexpr size_t digest_bytes = Bits / 8;
+        using digest_type = std::array<uint8_t, digest_bytes>;
+        using CryptographicHash::get;
+        using CryptographicHash::operator();
+        void operator()(const void* ptr, size_t len, digest_type& digest) { clear(); add(ptr, len); get(digest); }
+        void get(digest_type& digest) noexcept { get(digest.data()); }
+        digest_type digest() noexcept { digest_type d; get(d); return d; }
+    protected:
+        BasicCryptographicHash() noexcept: CryptographicHash(Bits) {}
+    };
+
+    class MD5:
+    public BasicCryptographicHash<128> {
+    public:
+        MD5() = default;
+        ~MD5() noexcept override { abort(); }
     private:
+        void do_init() noexcept override;
         void do_add(const void* ptr, size_t len) override;
         void do_final() noexcept override;
+        void do_abort() noexcept override;
     };
 
     class SHA1:
-    public CryptographicHash {
+    public BasicCryptographicHash<160> {
     public:
-        SHA1(): CryptographicHash(160) {}
-        ~SHA1() noexcept override { do_final(); }
+        SHA1() = default;
+        ~SHA1() noexcept override { abort(); }
     private:
+        void do_init() noexcept override;
         void do_add(const void* ptr, size_t len) override;
         void do_final() noexcept override;
+        void do_abort() noexcept override;
     };
 
     class SHA256:
-    public CryptographicHash {
+    public BasicCryptographicHash<256> {
     public:
-        SHA256(): CryptographicHash(256) {}
-        ~SHA256() noexcept override { do_final(); }
+        SHA256() = default;
+        ~SHA256() noexcept override { abort(); }
+        static bool hardware_accelerated() noexcept;
+        static void hash_batch(const void* const* ptrs, const size_t* lens, size_t count, digest_type* out);
     private:
+        void do_init() noexcept override;
         void do_add(const void* ptr, size_t len) override;
         void do_final() noexcept override;
     };
 
     class SHA512:
-    public CryptographicHash {
+    public BasicCryptographicHash<512> {
     public:
-        SHA512(): CryptographicHash(512) {}
-        ~SHA512() noexcept override { do_final(); }
+        SHA512() = default;
+        ~SHA512() noexcept override { abort(); }
     private:
+        void do_init() noexcept override;
         void do_add(const void* ptr, size_t len) override;
         void do_final() noexcept override;
     };
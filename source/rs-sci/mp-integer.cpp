@@ -1,35 +1,1338 @@
 #include "rs-sci/mp-integer.hpp"
+#include "rs-sci/prime.hpp"
 #include <cstring>
+#include <iterator>
 #include <stdexcept>
 
+// Crossover points for the multiplication algorithms, measured in limbs of
+// the smaller operand. The defaults depend on the limb width; they can be
+// overridden at build time (see the CMake cache variables of the same names).
+
+#ifndef RS_SCI_MPN_KARATSUBA_THRESHOLD
+    #define RS_SCI_MPN_KARATSUBA_THRESHOLD 32
+#endif
+
+#ifndef RS_SCI_MPN_TOOM3_THRESHOLD
+    #if RS_SCI_MPN_LIMB_BITS == 64
+        #define RS_SCI_MPN_TOOM3_THRESHOLD 512
+    #else
+        #define RS_SCI_MPN_TOOM3_THRESHOLD 256
+    #endif
+#endif
+
+#ifndef RS_SCI_MPN_NTT_THRESHOLD
+    #if RS_SCI_MPN_LIMB_BITS == 64
+        #define RS_SCI_MPN_NTT_THRESHOLD 6144
+    #else
+        #define RS_SCI_MPN_NTT_THRESHOLD 1536
+    #endif
+#endif
+
 using namespace RS::Format;
 
-namespace RS::Sci {
+namespace RS::Sci {
+
+    namespace {
+
+        std::string roman(const MPN& n, bool lcase = false) {
+
+            static constexpr std::pair<int, const char*> table[] = {
+                { 900, "CM" }, { 500, "D" }, { 400, "CD" }, { 100, "C" },
+                { 90, "XC" }, { 50, "L" }, { 40, "XL" }, { 10, "X" },
+                { 9, "IX" }, { 5, "V" }, { 4, "IV" }, { 1, "I" },
+            };
+
+            std::string rom(size_t(n / 1000), 'M');
+            auto m = n;
+            m %= 1000;
+
+            for (auto [num,str]: table) {
+                for (MPN q = m / num; q > 0; --q)
+                    rom += str;
+                m %= num;
+            }
+
+            if (lcase)
+                rom = ascii_lowercase(rom);
+
+            return rom;
+
+        }
+
+        // Low level arithmetic on little endian word arrays. A word is one
+        // limb of the MPN representation; Dword holds a double width product.
+
+        using Word = MPN::limb_type;
+        #if RS_SCI_MPN_LIMB_BITS == 64
+            __extension__ using Dword = unsigned __int128;
+        #else
+            using Dword = uint64_t;
+        #endif
+
+        constexpr int word_bits = MPN::limb_bits;
+        constexpr Word word_max = ~ Word(0);
+
+        using Words = Detail::LimbVector<Word, 256 / word_bits>; // Same type as MPN::rep_
+
+        constexpr size_t karatsuba_threshold = std::max(RS_SCI_MPN_KARATSUBA_THRESHOLD, 4);
+        constexpr size_t toom3_threshold = std::max(RS_SCI_MPN_TOOM3_THRESHOLD, 9);
+        constexpr size_t ntt_threshold = std::max(RS_SCI_MPN_NTT_THRESHOLD, 1);
+
+        size_t significant_words(const Word* x, size_t n) noexcept {
+            while (n > 0 && x[n - 1] == 0)
+                --n;
+            return n;
+        }
+
+        // z[0,m) = x[0,m) + y[0,n), requires m>=n, returns carry
+
+        Word add_words(Word* z, const Word* x, size_t m, const Word* y, size_t n) noexcept {
+            Dword sum = 0;
+            size_t i = 0;
+            for (; i < n; ++i) {
+                sum += Dword(x[i]) + Dword(y[i]);
+                z[i] = Word(sum);
+                sum >>= word_bits;
+            }
+            for (; i < m; ++i) {
+                sum += Dword(x[i]);
+                z[i] = Word(sum);
+                sum >>= word_bits;
+            }
+            return Word(sum);
+        }
+
+        // z[0,m) += y[0,n), requires m>=n, returns carry
+
+        Word add_in_place(Word* z, size_t m, const Word* y, size_t n) noexcept {
+            Dword sum = 0;
+            size_t i = 0;
+            for (; i < n; ++i) {
+                sum += Dword(z[i]) + Dword(y[i]);
+                z[i] = Word(sum);
+                sum >>= word_bits;
+            }
+            for (; sum && i < m; ++i) {
+                sum += Dword(z[i]);
+                z[i] = Word(sum);
+                sum >>= word_bits;
+            }
+            return Word(sum);
+        }
+
+        // z[0,m) = x[0,m) - y[0,n), requires m>=n, returns borrow
+
+        Word subtract_words(Word* z, const Word* x, size_t m, const Word* y, size_t n) noexcept {
+            Dword borrow = 0;
+            size_t i = 0;
+            for (; i < n; ++i) {
+                Dword d = Dword(x[i]) - Dword(y[i]) - borrow;
+                z[i] = Word(d);
+                borrow = d >> (2 * word_bits - 1);
+            }
+            for (; i < m; ++i) {
+                Word w = x[i];
+                z[i] = w - Word(borrow);
+                borrow = borrow && w == 0;
+            }
+            return Word(borrow);
+        }
+
+        // z[0,m) -= y[0,n), requires m>=n, returns borrow
+
+        Word subtract_in_place(Word* z, size_t m, const Word* y, size_t n) noexcept {
+            Dword borrow = 0;
+            size_t i = 0;
+            for (; i < n; ++i) {
+                Dword d = Dword(z[i]) - Dword(y[i]) - borrow;
+                z[i] = Word(d);
+                borrow = d >> (2 * word_bits - 1);
+            }
+            for (; borrow && i < m; ++i)
+                borrow = z[i]-- == 0;
+            return Word(borrow);
+        }
+
+        // q[0,m) = x[0,m) / d, returns remainder; q and x may be the same array
+
+        Word divide_by_word(Word* q, const Word* x, size_t m, Word d) noexcept {
+            Dword rem = 0;
+            for (size_t i = m - 1; i != std::string::npos; --i) {
+                rem = (rem << word_bits) + x[i];
+                q[i] = Word(rem / d);
+                rem %= d;
+            }
+            return Word(rem);
+        }
+
+        // z[0,m) += x[0,m) * y, returns carry
+
+        Word add_multiple(Word* z, const Word* x, size_t m, Word y) noexcept {
+            Dword carry = 0;
+            for (size_t i = 0; i < m; ++i) {
+                carry += Dword(x[i]) * y + z[i];
+                z[i] = Word(carry);
+                carry >>= word_bits;
+            }
+            return Word(carry);
+        }
+
+        // z[0,m) -= x[0,m) * y, returns borrow
+
+        Word subtract_multiple(Word* z, const Word* x, size_t m, Word y) noexcept {
+            Dword borrow = 0;
+            for (size_t i = 0; i < m; ++i) {
+                Dword p = Dword(x[i]) * y + borrow;
+                auto low = Word(p);
+                borrow = (p >> word_bits) + Dword(z[i] < low);
+                z[i] -= low;
+            }
+            return Word(borrow);
+        }
+
+        // z[0,n) = -z[0,n) (two's complement)
+
+        void negate_words(Word* z, size_t n) noexcept {
+            size_t i = 0;
+            while (i < n && z[i] == 0)
+                ++i;
+            if (i < n) {
+                z[i] = - z[i];
+                for (++i; i < n; ++i)
+                    z[i] = ~ z[i];
+            }
+        }
+
+        void multiply_words(Word* z, const Word* x, size_t m, const Word* y, size_t n,
+            MulAlgorithm alg = MulAlgorithm::automatic);
+
+        // Classic O(m*n) long multiplication, summing one column of partial
+        // products at a time. z[0,m+n) = x[0,m) * y[0,n).
+
+        void multiply_schoolbook(Word* z, const Word* x, size_t m, const Word* y, size_t n) noexcept {
+
+            std::fill(z, z + m + n, 0);
+            Dword carry = 0;
+
+            for (size_t k = 0; k <= m + n - 2; ++k) {
+
+                carry += Dword(z[k]);
+                z[k] = Word(carry);
+                carry >>= word_bits;
+                size_t i_min = k < n ? 0 : k - n + 1;
+                size_t i_max = k < m ? k : m - 1;
+
+                for (size_t i = i_min; i <= i_max; ++i) {
+                    Dword p = Dword(x[i]) * Dword(y[k - i]) + Dword(z[k]);
+                    z[k] = Word(p);
+                    carry += Word(p >> word_bits);
+                }
+
+            }
+
+            z[m + n - 1] = Word(carry);
+
+        }
+
+        // Karatsuba multiplication, O(n^1.58). Requires n<=m<2n. Splitting
+        // at k=m/2 gives x=x1*B+x0 and y=y1*B+y0, and the middle term
+        // x0*y1+x1*y0 is (x0+x1)*(y0+y1)-x0*y0-x1*y1.
+
+        void multiply_karatsuba(Word* z, const Word* x, size_t m, const Word* y, size_t n) {
+
+            size_t k = m / 2;
+            size_t m1 = m - k;
+            size_t n1 = n - k;
+
+            multiply_words(z, x, k, y, k);
+            multiply_words(z + 2 * k, x + k, m1, y + k, n1);
+
+            Words sx(m1 + 1), sy(std::max(k, n1) + 1);
+            sx[m1] = add_words(sx.data(), x + k, m1, x, k);
+            if (n1 >= k)
+                sy[n1] = add_words(sy.data(), y + k, n1, y, k);
+            else
+                sy[k] = add_words(sy.data(), y, k, y + k, n1);
+
+            size_t sxn = significant_words(sx.data(), sx.size());
+            size_t syn = significant_words(sy.data(), sy.size());
+            Words mid(sx.size() + sy.size(), 0);
+            if (sxn > 0 && syn > 0)
+                multiply_words(mid.data(), sx.data(), sxn, sy.data(), syn);
+
+            subtract_in_place(mid.data(), mid.size(), z, 2 * k);
+            subtract_in_place(mid.data(), mid.size(), z + 2 * k, m1 + n1);
+            add_in_place(z + k, m + n - k, mid.data(), significant_words(mid.data(), mid.size()));
+
+        }
+
+        // Signed intermediate values for Toom-Cook
+
+        struct SignedWords {
+            Words mag; // No leading zeros
+            bool neg = false;
+        };
+
+        Words to_words(const Word* x, size_t n) {
+            return Words(x, x + significant_words(x, n));
+        }
+
+        int compare_words(const Words& x, const Words& y) noexcept {
+            if (x.size() != y.size())
+                return x.size() < y.size() ? -1 : 1;
+            for (size_t i = x.size() - 1; i != std::string::npos; --i)
+                if (x[i] != y[i])
+                    return x[i] < y[i] ? -1 : 1;
+            return 0;
+        }
+
+        int compare_words(const Word* x, const Word* y, size_t n) noexcept {
+            for (size_t i = n - 1; i != std::string::npos; --i)
+                if (x[i] != y[i])
+                    return x[i] < y[i] ? -1 : 1;
+            return 0;
+        }
+
+        SignedWords add_signed(const SignedWords& x, const SignedWords& y) {
+            SignedWords z;
+            const auto* a = &x;
+            const auto* b = &y;
+            if (x.neg == y.neg) {
+                if (a->mag.size() < b->mag.size())
+                    std::swap(a, b);
+                z.mag.resize(a->mag.size() + 1);
+                z.mag.back() = add_words(z.mag.data(), a->mag.data(), a->mag.size(), b->mag.data(), b->mag.size());
+                z.neg = x.neg;
+            } else {
+                int c = compare_words(a->mag, b->mag);
+                if (c == 0)
+                    return z;
+                if (c < 0)
+                    std::swap(a, b);
+                z.mag = a->mag;
+                subtract_in_place(z.mag.data(), z.mag.size(), b->mag.data(), b->mag.size());
+                z.neg = a->neg;
+            }
+            z.mag.resize(significant_words(z.mag.data(), z.mag.size()));
+            return z;
+        }
+
+        SignedWords subtract_signed(const SignedWords& x, SignedWords y) {
+            if (! y.mag.empty())
+                y.neg = ! y.neg;
+            return add_signed(x, y);
+        }
+
+        SignedWords multiply_signed(const SignedWords& x, const SignedWords& y) {
+            SignedWords z;
+            if (x.mag.empty() || y.mag.empty())
+                return z;
+            z.mag.resize(x.mag.size() + y.mag.size());
+            multiply_words(z.mag.data(), x.mag.data(), x.mag.size(), y.mag.data(), y.mag.size());
+            z.mag.resize(significant_words(z.mag.data(), z.mag.size()));
+            z.neg = x.neg != y.neg;
+            return z;
+        }
+
+        void shift_left_signed(SignedWords& x, int bits) {
+            Word prev = 0;
+            for (auto& w: x.mag) {
+                Word next = w >> (word_bits - bits);
+                w = (w << bits) | prev;
+                prev = next;
+            }
+            if (prev)
+                x.mag.push_back(prev);
+        }
+
+        // Exact division by a small divisor (the remainder is known to be zero)
+
+        void divide_exact_signed(SignedWords& x, Word d) noexcept {
+            divide_by_word(x.mag.data(), x.mag.data(), x.mag.size(), d);
+            x.mag.resize(significant_words(x.mag.data(), x.mag.size()));
+        }
+
+        // Toom-Cook 3-way multiplication, O(n^1.46). Requires n<=m and n>2k,
+        // where k=ceil(m/3). Evaluates at 0, 1, -1, -2, and infinity, and
+        // interpolates using Bodrato's sequence.
+
+        void multiply_toom3(Word* z, const Word* x, size_t m, const Word* y, size_t n) {
+
+            size_t k = (m + 2) / 3;
+            SignedWords x0{to_words(x, k)}, x1{to_words(x + k, k)}, x2{to_words(x + 2 * k, m - 2 * k)};
+            SignedWords y0{to_words(y, k)}, y1{to_words(y + k, k)}, y2{to_words(y + 2 * k, n - 2 * k)};
+
+            auto evaluate = [] (const SignedWords& a0, const SignedWords& a1, const SignedWords& a2,
+                    SignedWords& p1, SignedWords& pm1, SignedWords& pm2) {
+                auto t = add_signed(a0, a2);
+                p1 = add_signed(t, a1);
+                pm1 = subtract_signed(t, a1);
+                pm2 = add_signed(pm1, a2);
+                shift_left_signed(pm2, 1);
+                pm2 = subtract_signed(pm2, a0);
+            };
+
+            SignedWords xp1, xm1, xm2, yp1, ym1, ym2;
+            evaluate(x0, x1, x2, xp1, xm1, xm2);
+            evaluate(y0, y1, y2, yp1, ym1, ym2);
+
+            auto r0 = multiply_signed(x0, y0);
+            auto r1 = multiply_signed(xp1, yp1);
+            auto rm1 = multiply_signed(xm1, ym1);
+            auto rm2 = multiply_signed(xm2, ym2);
+            auto rinf = multiply_signed(x2, y2);
+
+            auto c3 = subtract_signed(rm2, r1);
+            divide_exact_signed(c3, 3);
+            auto c1 = subtract_signed(r1, rm1);
+            divide_exact_signed(c1, 2);
+            auto c2 = subtract_signed(rm1, r0);
+            c3 = subtract_signed(c2, c3);
+            divide_exact_signed(c3, 2);
+            auto rinf2 = rinf;
+            shift_left_signed(rinf2, 1);
+            c3 = add_signed(c3, rinf2);
+            c2 = add_signed(c2, c1);
+            c2 = subtract_signed(c2, rinf);
+            c1 = subtract_signed(c1, c3);
+
+            // All coefficients are now non-negative
+
+            std::fill(z, z + m + n, 0);
+            const SignedWords* coeffs[] = { &r0, &c1, &c2, &c3, &rinf };
+
+            for (size_t i = 0; i < 5; ++i) {
+                auto& c = coeffs[i]->mag;
+                if (! c.empty())
+                    add_in_place(z + i * k, m + n - i * k, c.data(), c.size());
+            }
+
+        }
+
+        using Words32 = std::vector<uint32_t>;
+
+        // Number theoretic transform modulo a prime P=c*2^k+1, where G is a
+        // quadratic non-residue mod P. The transform length must be a power
+        // of 2, no larger than 2^k.
+
+        template <uint32_t P, uint32_t G>
+        class NttPrime {
+
+        public:
+
+            static constexpr uint32_t mul(uint32_t a, uint32_t b) noexcept {
+                return uint32_t(uint64_t(a) * uint64_t(b) % P);
+            }
+
+            static constexpr uint32_t power(uint32_t a, uint64_t n) noexcept {
+                uint32_t r = 1;
+                for (; n; n >>= 1) {
+                    if (n & 1)
+                        r = mul(r, a);
+                    a = mul(a, a);
+                }
+                return r;
+            }
+
+            static constexpr uint32_t inverse(uint32_t a) noexcept {
+                return power(a, P - 2);
+            }
+
+            // Cyclic convolution of x[0,m) and y[0,n), length len
+
+            static Words32 convolve(const uint32_t* x, size_t m, const uint32_t* y, size_t n, size_t len) {
+                Words32 a(len, 0), b(len, 0);
+                for (size_t i = 0; i < m; ++i)
+                    a[i] = x[i] % P;
+                for (size_t i = 0; i < n; ++i)
+                    b[i] = y[i] % P;
+                transform(a, false);
+                transform(b, false);
+                for (size_t i = 0; i < len; ++i)
+                    a[i] = mul(a[i], b[i]);
+                transform(a, true);
+                uint32_t scale = inverse(uint32_t(len % P));
+                for (auto& v: a)
+                    v = mul(v, scale);
+                return a;
+            }
+
+        private:
+
+            static void transform(Words32& a, bool inverse_transform) {
+
+                size_t len = a.size();
+
+                for (size_t i = 1, j = 0; i < len; ++i) {
+                    size_t bit = len >> 1;
+                    for (; j & bit; bit >>= 1)
+                        j ^= bit;
+                    j ^= bit;
+                    if (i < j)
+                        std::swap(a[i], a[j]);
+                }
+
+                uint32_t root = power(G, (P - 1) / len);
+                if (inverse_transform)
+                    root = inverse(root);
+                Words32 roots(len / 2);
+                if (! roots.empty())
+                    roots[0] = 1;
+                for (size_t i = 1; i < roots.size(); ++i)
+                    roots[i] = mul(roots[i - 1], root);
+
+                for (size_t half = 1; half < len; half *= 2) {
+                    size_t stride = len / (2 * half);
+                    for (size_t i = 0; i < len; i += 2 * half) {
+                        for (size_t j = 0; j < half; ++j) {
+                            uint32_t u = a[i + j];
+                            uint32_t v = mul(a[i + j + half], roots[j * stride]);
+                            a[i + j] = u + v >= P ? u + v - P : u + v;
+                            a[i + j + half] = u >= v ? u - v : u + P - v;
+                        }
+                    }
+                }
+
+            }
+
+        };
+
+        using Ntt1 = NttPrime<998'244'353, 3>; // 119*2^23+1
+        using Ntt2 = NttPrime<167'772'161, 3>; // 5*2^25+1
+        using Ntt3 = NttPrime<469'762'049, 3>; // 7*2^26+1
+
+        // The product of the three primes is just over 2^86, so each
+        // convolution term (at most min(m,n)*(2^32-1)^2) is exact as long as
+        // min(m,n)<=2^22, which the transform length limit already implies.
+        // The transforms work on 32-bit pieces; the limit is in words.
+
+        constexpr size_t ntt_max_length = (size_t(1) << 23) / (word_bits / 32);
+
+        // Multiplication by number theoretic transforms modulo three primes,
+        // O(n log n), recombined by the Chinese remainder theorem (Garner's
+        // algorithm). Requires m+n<=2^23.
+
+        void multiply_ntt32(uint32_t* z, const uint32_t* x, size_t m, const uint32_t* y, size_t n) {
+
+            constexpr uint64_t p1 = 998'244'353;
+            constexpr uint64_t p2 = 167'772'161;
+            constexpr uint64_t p3 = 469'762'049;
+            constexpr uint64_t p12 = p1 * p2;
+            constexpr uint64_t low32 = 0xffff'ffff;
+            constexpr uint32_t inv_p1_mod_p2 = Ntt2::inverse(uint32_t(p1 % p2));
+            constexpr uint32_t inv_p12_mod_p3 = Ntt3::inverse(uint32_t(p12 % p3));
+
+            size_t len = 1;
+            while (len < m + n - 1)
+                len *= 2;
+
+            auto r1 = Ntt1::convolve(x, m, y, n, len);
+            auto r2 = Ntt2::convolve(x, m, y, n, len);
+            auto r3 = Ntt3::convolve(x, m, y, n, len);
+            uint64_t carry = 0;
+
+            for (size_t i = 0; i < m + n; ++i) {
+
+                uint64_t sum_low = carry & low32;
+                uint64_t sum_high = carry >> 32;
+
+                if (i < m + n - 1) {
+
+                    // term = v1 + p1*v2 + p1*p2*v3, where v1<p1, v2<p2, v3<p3
+
+                    uint64_t v1 = r1[i];
+                    uint64_t v2 = Ntt2::mul(uint32_t((r2[i] + p2 - v1 % p2) % p2), inv_p1_mod_p2);
+                    uint64_t a = v1 + p1 * v2;
+                    uint64_t v3 = Ntt3::mul(uint32_t((r3[i] + p3 - a % p3) % p3), inv_p12_mod_p3);
+                    uint64_t b_low = (p12 & low32) * v3;
+                    uint64_t b_high = (p12 >> 32) * v3;
+                    sum_low += (a & low32) + (b_low & low32);
+                    sum_high += (a >> 32) + (b_low >> 32) + b_high;
+
+                }
+
+                z[i] = uint32_t(sum_low);
+                carry = (sum_low >> 32) + sum_high;
+
+            }
+
+        }
+
+        #if RS_SCI_MPN_LIMB_BITS == 64
+
+            // Split 64-bit words into 32-bit halves for the transforms
+
+            void multiply_ntt(Word* z, const Word* x, size_t m, const Word* y, size_t n) {
+
+                auto split = [] (const Word* a, size_t k) {
+                    Words32 b(2 * k);
+                    for (size_t i = 0; i < k; ++i) {
+                        b[2 * i] = uint32_t(a[i]);
+                        b[2 * i + 1] = uint32_t(a[i] >> 32);
+                    }
+                    return b;
+                };
+
+                auto xs = split(x, m);
+                auto ys = split(y, n);
+                Words32 zs(2 * (m + n));
+                multiply_ntt32(zs.data(), xs.data(), 2 * m, ys.data(), 2 * n);
+
+                for (size_t i = 0; i < m + n; ++i)
+                    z[i] = Word(zs[2 * i]) | (Word(zs[2 * i + 1]) << 32);
+
+            }
+
+        #else
+
+            void multiply_ntt(Word* z, const Word* x, size_t m, const Word* y, size_t n) {
+                multiply_ntt32(z, x, m, y, n);
+            }
+
+        #endif
+
+        // Choose an algorithm based on the size of the operands
+
+        void multiply_words(Word* z, const Word* x, size_t m, const Word* y, size_t n, MulAlgorithm alg) {
+
+            if (m < n) {
+                std::swap(x, y);
+                std::swap(m, n);
+            }
+
+            if (alg == MulAlgorithm::automatic) {
+                if (n < karatsuba_threshold)
+                    alg = MulAlgorithm::schoolbook;
+                else if (n < toom3_threshold)
+                    alg = MulAlgorithm::karatsuba;
+                else if (n < ntt_threshold)
+                    alg = MulAlgorithm::toom3;
+                else
+                    alg = MulAlgorithm::ntt;
+            }
+
+            if (alg == MulAlgorithm::ntt && m + n > ntt_max_length)
+                alg = MulAlgorithm::toom3;
+
+            if (alg == MulAlgorithm::schoolbook || (n < 4 && alg != MulAlgorithm::ntt)) {
+
+                multiply_schoolbook(z, x, m, y, n);
+
+            } else if (alg == MulAlgorithm::ntt) {
+
+                multiply_ntt(z, x, m, y, n);
+
+            } else if (m >= 2 * n) {
+
+                // Unbalanced operands: multiply n-word slices of x by y
+
+                std::fill(z, z + m + n, 0);
+                Words part(2 * n);
+
+                for (size_t i = 0; i < m; i += n) {
+                    size_t len = std::min(n, m - i);
+                    multiply_words(part.data(), x + i, len, y, n, alg);
+                    add_in_place(z + i, m + n - i, part.data(), len + n);
+                }
+
+            } else if (alg == MulAlgorithm::toom3 && n >= 9 && n > 2 * ((m + 2) / 3)) {
+
+                multiply_toom3(z, x, m, y, n);
+
+            } else {
+
+                multiply_karatsuba(z, x, m, y, n);
+
+            }
+
+        }
+
+
+        // Long division one word at a time (Knuth, TAOCP vol 2, 4.3.1,
+        // Algorithm D). Requires m>=n>=2 and y[n-1]!=0. On return q has m-n+1
+        // words and r has n words, neither trimmed.
+
+        void divide_knuth(const Word* x, size_t m, const Word* y, size_t n, Words& q, Words& r) {
+
+            // Normalize so the divisor's top bit is set
+
+            int shift = word_bits - TL::bit_width(y[n - 1]);
+            Words v(n), u(m + 1);
+
+            for (size_t i = n - 1; i > 0; --i)
+                v[i] = shift ? (y[i] << shift) | (y[i - 1] >> (word_bits - shift)) : y[i];
+            v[0] = y[0] << shift;
+            u[m] = shift ? x[m - 1] >> (word_bits - shift) : 0;
+            for (size_t i = m - 1; i > 0; --i)
+                u[i] = shift ? (x[i] << shift) | (x[i - 1] >> (word_bits - shift)) : x[i];
+            u[0] = x[0] << shift;
+
+            q.assign(m - n + 1, 0);
+            Dword v1 = v[n - 1];
+            Dword v2 = v[n - 2];
+
+            for (size_t j = m - n; j != std::string::npos; --j) {
+
+                // Estimate the quotient word from the top two words of the
+                // remainder; this is at most 2 too large, and the test
+                // against v2 corrects it in almost all cases
+
+                Dword num = (Dword(u[j + n]) << word_bits) | u[j + n - 1];
+                Dword qhat = num / v1;
+                Dword rhat = num % v1;
+
+                while (qhat > word_max || qhat * v2 > ((rhat << word_bits) | u[j + n - 2])) {
+                    --qhat;
+                    rhat += v1;
+                    if (rhat > word_max)
+                        break;
+                }
+
+                // Multiply and subtract
+
+                Dword borrow = 0;
+
+                for (size_t i = 0; i < n; ++i) {
+                    Dword p = qhat * v[i] + borrow;
+                    auto low = Word(p);
+                    borrow = (p >> word_bits) + Dword(u[i + j] < low);
+                    u[i + j] -= low;
+                }
+
+                bool negative = u[j + n] < borrow;
+                u[j + n] -= Word(borrow);
+
+                // The estimate was still one too large: add back
+
+                if (negative) {
+                    --qhat;
+                    u[j + n] += add_in_place(u.data() + j, n, v.data(), n);
+                }
+
+                q[j] = Word(qhat);
+
+            }
+
+            // Unnormalize the remainder
+
+            r.resize(n);
+            for (size_t i = 0; i < n - 1; ++i)
+                r[i] = shift ? (u[i] >> shift) | (u[i + 1] << (word_bits - shift)) : u[i];
+            r[n - 1] = u[n - 1] >> shift;
+            if (shift)
+                r[n - 1] |= u[n] << (word_bits - shift);
+
+        }
+
+        // Word vector utilities for radix conversion
+
+        void trim_words(Words& x) noexcept {
+            x.resize(significant_words(x.data(), x.size()));
+        }
+
+        size_t bit_length(const Words& x) noexcept {
+            return x.empty() ? 0 : word_bits * (x.size() - 1) + TL::bit_width(x.back());
+        }
+
+        Words multiply_trimmed(const Words& x, const Words& y) {
+            if (x.empty() || y.empty())
+                return {};
+            Words z(x.size() + y.size());
+            multiply_words(z.data(), x.data(), x.size(), y.data(), y.size(), MulAlgorithm::automatic);
+            trim_words(z);
+            return z;
+        }
+
+        Words shift_left_words(const Words& x, size_t bits) {
+            if (x.empty())
+                return {};
+            size_t words = bits / word_bits;
+            int shift = int(bits % word_bits);
+            Words z(x.size() + words + 1, 0);
+            for (size_t i = 0; i < x.size(); ++i) {
+                z[i + words] |= x[i] << shift;
+                if (shift)
+                    z[i + words + 1] = x[i] >> (word_bits - shift);
+            }
+            trim_words(z);
+            return z;
+        }
+
+        Words shift_right_words(const Words& x, size_t bits) {
+            size_t words = bits / word_bits;
+            if (words >= x.size())
+                return {};
+            int shift = int(bits % word_bits);
+            Words z(x.size() - words);
+            for (size_t i = 0; i < z.size(); ++i) {
+                z[i] = x[i + words] >> shift;
+                if (shift && i + words + 1 < x.size())
+                    z[i] |= x[i + words + 1] << (word_bits - shift);
+            }
+            trim_words(z);
+            return z;
+        }
+
+        // x = x*m+a
+
+        void multiply_add_word(Words& x, Word m, Word a) {
+            Dword carry = a;
+            for (auto& w: x) {
+                carry += Dword(w) * m;
+                w = Word(carry);
+                carry >>= word_bits;
+            }
+            if (carry)
+                x.push_back(Word(carry));
+        }
+
+        // Division by large constant divisors, used by the radix conversion
+        // to split a number into high and low halves. When the divisor or
+        // the quotient is below the threshold (in words) Knuth's algorithm
+        // is used; otherwise the divisor's reciprocal is computed once by
+        // Newton iteration, and each division costs two multiplications
+        // (Barrett reduction).
+
+        constexpr size_t barrett_threshold = 65536 / word_bits;
+
+        // Returns floor(2^2b/d), where d has exactly b bits
+
+        Words reciprocal(const Words& d) {
+
+            size_t b = bit_length(d);
+
+            if (d.size() <= barrett_threshold) {
+                Words x(2 * b / word_bits + 1, 0), q, r;
+                x.back() = Word(1) << (2 * b % word_bits);
+                if (d.size() == 1) {
+                    q.resize(x.size());
+                    divide_by_word(q.data(), x.data(), x.size(), d[0]);
+                } else {
+                    divide_knuth(x.data(), x.size(), d.data(), d.size(), q, r);
+                }
+                trim_words(q);
+                return q;
+            }
+
+            // Start from the reciprocal of the top half of the divisor; one
+            // Newton step, r' = 2r-dr^2/2^2b, doubles the number of correct
+            // bits, leaving an error of a few units that is fixed below
+
+            size_t h = b / 2 + 4;
+            Words r = shift_left_words(reciprocal(shift_right_words(d, b - h)), b - h);
+            Words t = shift_right_words(multiply_trimmed(d, multiply_trimmed(r, r)), 2 * b);
+            r = shift_left_words(r, 1);
+            subtract_in_place(r.data(), r.size(), t.data(), t.size());
+            trim_words(r);
+
+            Words limit(2 * b / word_bits + 1, 0);
+            limit.back() = Word(1) << (2 * b % word_bits);
+            Words p = multiply_trimmed(r, d);
+            Words one = {1};
+
+            while (compare_words(p, limit) > 0) {
+                subtract_in_place(r.data(), r.size(), one.data(), 1);
+                subtract_in_place(p.data(), p.size(), d.data(), d.size());
+                trim_words(r);
+                trim_words(p);
+            }
+
+            for (;;) {
+                Words gap = limit;
+                subtract_in_place(gap.data(), gap.size(), p.data(), p.size());
+                trim_words(gap);
+                if (compare_words(gap, d) < 0)
+                    break;
+                if (add_in_place(r.data(), r.size(), one.data(), 1))
+                    r.push_back(1);
+                p.resize(std::max(p.size(), d.size()) + 1, 0);
+                add_in_place(p.data(), p.size(), d.data(), d.size());
+                trim_words(p);
+            }
+
+            return r;
+
+        }
+
+        struct RadixPower {
+            Words value;
+            Words inverse; // Filled in on first use
+            size_t digits = 0;
+        };
+
+        // q = x/p, r = x%p, requires x<p^2
+
+        void divide_by_power(const Words& x, RadixPower& p, Words& q, Words& r) {
+
+            const Words& d = p.value;
+
+            if (compare_words(x, d) < 0) {
+                q.clear();
+                r = x;
+                return;
+            }
+
+            if (d.size() == 1) {
+                q.resize(x.size());
+                r.assign(1, divide_by_word(q.data(), x.data(), x.size(), d[0]));
+            } else if (d.size() <= barrett_threshold || x.size() - d.size() < barrett_threshold) {
+                divide_knuth(x.data(), x.size(), d.data(), d.size(), q, r);
+            } else {
+                if (p.inverse.empty())
+                    p.inverse = reciprocal(d);
+                q = shift_right_words(multiply_trimmed(x, p.inverse), 2 * bit_length(d));
+                r = x;
+                Words qd = multiply_trimmed(q, d);
+                subtract_in_place(r.data(), r.size(), qd.data(), qd.size());
+                trim_words(r);
+                Words one = {1};
+                while (compare_words(r, d) >= 0) {
+                    subtract_in_place(r.data(), r.size(), d.data(), d.size());
+                    trim_words(r);
+                    if (q.empty())
+                        q.push_back(0);
+                    if (add_in_place(q.data(), q.size(), one.data(), 1))
+                        q.push_back(1);
+                }
+            }
+
+            trim_words(q);
+            trim_words(r);
+
+        }
+
+        // Subquadratic radix conversion by recursive splitting around cached
+        // powers of the base, p[i]=b^(k*2^i), where b^k is the largest power
+        // of the base that fits in one word. Below the threshold (in words of
+        // the number being converted) conversion works one word at a time,
+        // handling k digits in each step.
+
+        constexpr size_t radix_split_threshold = 1280 / word_bits;
+        #if RS_SCI_MPN_LIMB_BITS == 64
+            constexpr Word decimal_chunk = 10'000'000'000'000'000'000u;
+            constexpr size_t decimal_chunk_digits = 19;
+        #else
+            constexpr Word decimal_chunk = 1'000'000'000;
+            constexpr size_t decimal_chunk_digits = 9;
+        #endif
+
+        // Append the decimal digits of x (trimmed) to out, zero padded on the
+        // left to the given width
+
+        void decimal_chunks(Words x, std::string& out, size_t width) {
+
+            std::vector<Word> chunks;
+
+            for (size_t n = x.size(); n > 0; n = significant_words(x.data(), n))
+                chunks.push_back(divide_by_word(x.data(), x.data(), n, decimal_chunk));
+
+            char buf[decimal_chunk_digits];
+            size_t top = 0;
+
+            if (! chunks.empty())
+                for (auto c = chunks.back(); c > 0; c /= 10)
+                    ++top;
+
+            size_t digits = decimal_chunk_digits * (chunks.size() - (chunks.empty() ? 0 : 1)) + top;
+
+            if (width > digits)
+                out.append(width - digits, '0');
+
+            for (size_t i = chunks.size() - 1; i != std::string::npos; --i) {
+                auto c = chunks[i];
+                size_t len = i == chunks.size() - 1 ? top : decimal_chunk_digits;
+                for (size_t j = len - 1; j != std::string::npos; --j, c /= 10)
+                    buf[j] = char('0' + c % 10);
+                out.append(buf, len);
+            }
+
+        }
+
+        // Requires x<p[level]^2
+
+        void decimal_recursive(const Words& x, std::vector<RadixPower>& powers, size_t level, std::string& out, size_t width) {
+
+            if (level == 0 || x.size() <= radix_split_threshold) {
+                decimal_chunks(x, out, width);
+                return;
+            }
+
+            auto& p = powers[level];
+
+            if (compare_words(x, p.value) < 0) {
+                decimal_recursive(x, powers, level - 1, out, width);
+                return;
+            }
+
+            Words q, r;
+            divide_by_power(x, p, q, r);
+            decimal_recursive(q, powers, level - 1, out, width > p.digits ? width - p.digits : 0);
+            decimal_recursive(r, powers, level - 1, out, p.digits);
+
+        }
+
+        // Returns the decimal representation of x (trimmed), with no leading
+        // zeros (and an empty string for zero)
+
+        std::string words_to_decimal(const Words& x) {
+
+            std::string out;
+
+            if (x.size() <= radix_split_threshold) {
+                decimal_chunks(x, out, 0);
+                return out;
+            }
+
+            std::vector<RadixPower> powers(1);
+            powers[0].value = {decimal_chunk};
+            powers[0].digits = decimal_chunk_digits;
+
+            while (2 * powers.back().value.size() - 1 <= x.size()) {
+                RadixPower next;
+                next.value = multiply_trimmed(powers.back().value, powers.back().value);
+                next.digits = 2 * powers.back().digits;
+                powers.push_back(std::move(next));
+            }
+
+            decimal_recursive(x, powers, powers.size() - 1, out, 0);
+
+            return out;
+
+        }
+
+        // Returns the digits of x (trimmed) in a power of two base, with no
+        // leading zeros, by slicing the bits directly
+
+        std::string words_to_binary_base(const Words& x, int bits_per_digit, const char* xdigits) {
+
+            size_t n = (bit_length(x) + bits_per_digit - 1) / bits_per_digit;
+            Word mask = (Word(1) << bits_per_digit) - 1;
+            std::string out(n, '0');
 
-    namespace {
+            for (size_t i = 0, pos = 0; i < n; ++i, pos += bits_per_digit) {
+                size_t w = pos / word_bits;
+                int s = int(pos % word_bits);
+                Word d = x[w] >> s;
+                if (s + bits_per_digit > word_bits && w + 1 < x.size())
+                    d |= x[w + 1] << (word_bits - s);
+                out[n - i - 1] = xdigits[d & mask];
+            }
 
-        std::string roman(const MPN& n, bool lcase = false) {
+            return out;
 
-            static constexpr std::pair<int, const char*> table[] = {
-                { 900, "CM" }, { 500, "D" }, { 400, "CD" }, { 100, "C" },
-                { 90, "XC" }, { 50, "L" }, { 40, "XL" }, { 10, "X" },
-                { 9, "IX" }, { 5, "V" }, { 4, "IV" }, { 1, "I" },
-            };
+        }
 
-            std::string rom(size_t(n / 1000), 'M');
-            auto m = n;
-            m %= 1000;
+        // Parse digit values (most significant first) in a power of two base
 
-            for (auto [num,str]: table) {
-                for (MPN q = m / num; q > 0; --q)
-                    rom += str;
-                m %= num;
+        Words binary_base_to_words(const std::vector<uint8_t>& digits, int bits_per_digit) {
+
+            Words x;
+            Dword acc = 0;
+            int nbits = 0;
+
+            for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+                acc |= Dword(*it) << nbits;
+                nbits += bits_per_digit;
+                if (nbits >= word_bits) {
+                    x.push_back(Word(acc));
+                    acc >>= word_bits;
+                    nbits -= word_bits;
+                }
             }
 
-            if (lcase)
-                rom = ascii_lowercase(rom);
+            if (nbits > 0)
+                x.push_back(Word(acc));
 
-            return rom;
+            trim_words(x);
+            return x;
+
+        }
+
+        struct RadixParser {
+
+            Word base;
+            Word chunk = 1; // Largest power of the base that fits in a word
+            size_t chunk_digits = 0;
+            std::vector<Words> powers; // chunk^(2^i)
+
+            explicit RadixParser(Word b): base(b) {
+                while (Dword(chunk) * base <= word_max) {
+                    chunk *= base;
+                    ++chunk_digits;
+                }
+                powers.push_back({chunk});
+            }
+
+            Words parse(const uint8_t* digits, size_t n) {
+
+                if (n <= chunk_digits * radix_split_threshold) {
+                    Words x;
+                    Word acc = 0, scale = 1;
+                    size_t count = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        acc = acc * base + digits[i];
+                        scale *= base;
+                        if (++count == chunk_digits || i == n - 1) {
+                            multiply_add_word(x, scale, acc);
+                            acc = 0;
+                            scale = 1;
+                            count = 0;
+                        }
+                    }
+                    trim_words(x);
+                    return x;
+                }
+
+                // Split so the low part is the largest cached power that
+                // leaves a nonempty high part
+
+                size_t level = 0, low = chunk_digits;
+                while (2 * low < n) {
+                    ++level;
+                    low *= 2;
+                }
+                while (powers.size() <= level)
+                    powers.push_back(multiply_trimmed(powers.back(), powers.back()));
+
+                Words x = multiply_trimmed(parse(digits, n - low), powers[level]);
+                Words y = parse(digits + n - low, low);
+
+                if (x.size() < y.size())
+                    x.swap(y);
+                if (! y.empty()) {
+                    x.push_back(0);
+                    add_in_place(x.data(), x.size(), y.data(), y.size());
+                    trim_words(x);
+                }
+
+                return x;
+
+            }
+
+        };
+
+        // Montgomery arithmetic modulo an odd n-word modulus m, with
+        // R=2^(n*word_bits). minv is -1/m[0] mod 2^word_bits.
+
+        Word montgomery_inverse(Word m0) noexcept {
+            Word inv = m0; // Correct to 3 bits for odd m0
+            for (int bits = 3; bits < word_bits; bits *= 2)
+                inv *= 2 - m0 * inv;
+            return - inv;
+        }
+
+        // z[0,n) = x*y/R mod m, with x,y < m, using coarsely integrated
+        // operand scanning (CIOS). t is scratch space of n+2 words. z may
+        // alias x or y.
+
+        void montgomery_multiply(Word* z, const Word* x, const Word* y, const Word* m, size_t n, Word minv, Word* t) noexcept {
+
+            std::fill(t, t + n + 2, 0);
+
+            for (size_t i = 0; i < n; ++i) {
+
+                Dword c = 0;
+                for (size_t j = 0; j < n; ++j) {
+                    c += Dword(x[j]) * y[i] + t[j];
+                    t[j] = Word(c);
+                    c >>= word_bits;
+                }
+                c += t[n];
+                t[n] = Word(c);
+                t[n + 1] = Word(c >> word_bits);
+
+                Word q = t[0] * minv;
+                c = (Dword(q) * m[0] + t[0]) >> word_bits;
+                for (size_t j = 1; j < n; ++j) {
+                    c += Dword(q) * m[j] + t[j];
+                    t[j - 1] = Word(c);
+                    c >>= word_bits;
+                }
+                c += t[n];
+                t[n - 1] = Word(c);
+                t[n] = t[n + 1] + Word(c >> word_bits);
+
+            }
+
+            bool ge = t[n] != 0;
+            if (! ge) {
+                size_t i = n - 1;
+                while (i > 0 && t[i] == m[i])
+                    --i;
+                ge = t[i] >= m[i];
+            }
+            if (ge)
+                subtract_words(t, t, n, m, n);
+            std::copy(t, t + n, z);
+
+        }
+
+        // Window width for sliding window exponentiation, chosen to
+        // minimize the total number of multiplications for the exponent size
+
+        int window_bits(size_t exp_bits) noexcept {
+            if (exp_bits <= 8)
+                return 1;
+            else if (exp_bits <= 24)
+                return 2;
+            else if (exp_bits <= 80)
+                return 3;
+            else if (exp_bits <= 240)
+                return 4;
+            else if (exp_bits <= 672)
+                return 5;
+            else
+                return 6;
+        }
+
+        // Helper functions for primality testing and factorization
+
+        constexpr uint64_t small_odd_primes[] = {
+            3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97,
+            101, 103, 107, 109, 113, 127, 131, 137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191,
+            193, 197, 199, 211, 223, 227, 229, 233, 239, 241, 251,
+        };
+
+        // Calls f(p) for each small odd prime p dividing n, in ascending
+        // order, stopping if f returns false. This uses one multiple
+        // precision division for each group of primes whose product fits in
+        // 64 bits. f may divide n by p.
+
+        template <typename F>
+        void find_small_factors(const MPN& n, F f) {
+            size_t i = 0;
+            while (i < std::size(small_odd_primes)) {
+                uint64_t product = 1;
+                size_t j = i;
+                for (; j < std::size(small_odd_primes) && product <= ~ uint64_t(0) / small_odd_primes[j]; ++j)
+                    product *= small_odd_primes[j];
+                auto r = uint64_t(n % product);
+                for (; i < j; ++i)
+                    if (r % small_odd_primes[i] == 0 && ! f(small_odd_primes[i]))
+                        return;
+            }
+        }
+
+        MPN gcd(MPN x, MPN y) {
+            while (y) {
+                x %= y;
+                std::swap(x, y);
+            }
+            return x;
+        }
+
+        // Jacobi symbol (a/n), for odd n
+
+        int jacobi(MPN a, MPN n) {
+            int j = 1;
+            a %= n;
+            while (a) {
+                for (; a.is_even(); a >>= 1) {
+                    int r = n.get_byte(0) & 7;
+                    if (r == 3 || r == 5)
+                        j = - j;
+                }
+                std::swap(a, n);
+                if ((a.get_byte(0) & 3) == 3 && (n.get_byte(0) & 3) == 3)
+                    j = - j;
+                a %= n;
+            }
+            return n == 1 ? j : 0;
+        }
+
+        bool is_square(const MPN& n) {
+            if (! n)
+                return true;
+            MPN x = MPN(1) << ((n.bits() + 1) / 2);
+            for (;;) {
+                MPN y = (x + n / x) >> 1;
+                if (y >= x)
+                    break;
+                x = std::move(y);
+            }
+            return x * x == n;
+        }
+
+        // x = x/2 mod n, for odd n and x<n
+
+        void halve_mod(MPN& x, const MPN& n) {
+            if (x.is_odd())
+                x += n;
+            x >>= 1;
+        }
+
+        // x = x^2-2y mod n, with x,y<n
+
+        void lucas_double(MPN& x, const MPN& y, const MPN& n) {
+            MPN a = x * x % n, b = (y << 1) % n;
+            if (a < b)
+                a += n;
+            x = a - b;
+        }
+
+        // Strong Lucas probable prime test, with the parameters chosen by
+        // Selfridge's method A (P=1 and the first D in 5,-7,9,-11,... with
+        // (D/n)=-1, Q=(1-D)/4), for odd n not divisible by small primes
+
+        bool is_strong_lucas_probable_prime(const MPN& n) {
+
+            int64_t d = 5;
+
+            for (;;) {
+                MPN abs_d = uint64_t(std::abs(d));
+                MPN dm = d > 0 ? abs_d % n : n - abs_d % n;
+                int j = jacobi(dm, n);
+                if (j == -1)
+                    break;
+                if (j == 0 && abs_d != n)
+                    return false;
+                if (d == 13 && is_square(n))
+                    return false;
+                d = d > 0 ? - d - 2 : - d + 2;
+            }
+
+            int64_t q = (1 - d) / 4;
+            MPN qm = q >= 0 ? MPN(uint64_t(q)) % n : n - MPN(uint64_t(- q)) % n;
+            MPN dm = d >= 0 ? MPN(uint64_t(d)) % n : n - MPN(uint64_t(- d)) % n;
+
+            // n+1 = k*2^s, with k odd
+
+            MPN k = n + 1;
+            size_t s = 0;
+            for (; k.is_even(); k >>= 1)
+                ++s;
+
+            // Compute U(k), V(k), and Q^k, starting from U(1)=1, V(1)=P=1
+
+            MPN u = 1, v = 1, qk = qm;
+
+            for (size_t i = k.bits() - 1; i-- > 0;) {
+                u = u * v % n;
+                lucas_double(v, qk, n);
+                qk = qk * qk % n;
+                if (k.get_bit(i)) {
+                    MPN u1 = u + v, v1 = dm * u + v;
+                    u1 %= n;
+                    v1 %= n;
+                    halve_mod(u1, n);
+                    halve_mod(v1, n);
+                    u = std::move(u1);
+                    v = std::move(v1);
+                    qk = qk * qm % n;
+                }
+            }
+
+            if (! u || ! v)
+                return true;
+
+            for (size_t r = 1; r < s; ++r) {
+                lucas_double(v, qk, n);
+                if (! v)
+                    return true;
+                qk = qk * qk % n;
+            }
+
+            return false;
 
         }
 
@@ -39,30 +1342,32 @@ namespace RS::Sci {
 
     MPN::MPN(uint64_t x) {
         if (x > 0)
-            rep_.push_back(uint32_t(x));
-        if (x > mask32)
-            rep_.push_back(uint32_t(x >> 32));
+            rep_.push_back(limb_type(x));
+        #if RS_SCI_MPN_LIMB_BITS == 32
+            if (x > limb_max)
+                rep_.push_back(uint32_t(x >> 32));
+        #endif
     }
 
     MPN& MPN::operator+=(const MPN& rhs) {
         size_t common = std::min(rep_.size(), rhs.rep_.size());
         rep_.resize(std::max(rep_.size(), rhs.rep_.size()), 0);
-        uint64_t sum = 0;
+        Dword sum = 0;
         for (size_t i = 0; i < common; ++i) {
-            sum += uint64_t(rep_[i]) + uint64_t(rhs.rep_[i]);
-            rep_[i] = uint32_t(sum);
-            sum >>= 32;
+            sum += Dword(rep_[i]) + Dword(rhs.rep_[i]);
+            rep_[i] = Word(sum);
+            sum >>= word_bits;
         }
         const auto* rptr = &rep_;
         if (rhs.rep_.size() > common)
             rptr = &rhs.rep_;
         for (size_t i = common; i < rep_.size(); ++i) {
-            sum += uint64_t((*rptr)[i]);
-            rep_[i] = uint32_t(sum);
-            sum >>= 32;
+            sum += Dword((*rptr)[i]);
+            rep_[i] = Word(sum);
+            sum >>= word_bits;
         }
         if (sum)
-            rep_.push_back(uint32_t(sum));
+            rep_.push_back(Word(sum));
         trim();
         return *this;
     }
@@ -78,7 +1383,7 @@ namespace RS::Sci {
             carry = c;
         }
         for (size_t i = common; carry && i < rep_.size(); ++i)
-            carry = --rep_[i] == mask32;
+            carry = --rep_[i] == limb_max;
         trim();
         return *this;
     }
@@ -93,17 +1398,17 @@ namespace RS::Sci {
     }
 
     MPN& MPN::operator|=(const MPN& rhs) {
-        size_t common = std::min(rep_.size(), rhs.rep_.size());
-        rep_.resize(std::max(rep_.size(), rhs.rep_.size()));
-        for (size_t i = 0; i < common; ++i)
+        if (rep_.size() < rhs.rep_.size())
+            rep_.resize(rhs.rep_.size(), 0);
+        for (size_t i = 0; i < rhs.rep_.size(); ++i)
             rep_[i] |= rhs.rep_[i];
         return *this;
     }
 
     MPN& MPN::operator^=(const MPN& rhs) {
-        size_t common = std::min(rep_.size(), rhs.rep_.size());
-        rep_.resize(std::max(rep_.size(), rhs.rep_.size()));
-        for (size_t i = 0; i < common; ++i)
+        if (rep_.size() < rhs.rep_.size())
+            rep_.resize(rhs.rep_.size(), 0);
+        for (size_t i = 0; i < rhs.rep_.size(); ++i)
             rep_[i] ^= rhs.rep_[i];
         trim();
         return *this;
@@ -114,12 +1419,12 @@ namespace RS::Sci {
             return *this;
         if (rhs < 0)
             return *this >>= - rhs;
-        size_t words = rhs / 32;
-        int bits = rhs % 32;
-        uint32_t prev = 0;
+        size_t words = rhs / limb_bits;
+        int bits = rhs % limb_bits;
+        limb_type prev = 0;
         if (bits > 0) {
             for (auto& word: rep_) {
-                uint32_t next = word >> (32 - bits);
+                limb_type next = word >> (limb_bits - bits);
                 word = (word << bits) | prev;
                 prev = next;
             }
@@ -135,16 +1440,16 @@ namespace RS::Sci {
             return *this;
         if (rhs < 0)
             return *this <<= - rhs;
-        size_t words = rhs / 32;
-        int bits = rhs % 32;
+        size_t words = rhs / limb_bits;
+        int bits = rhs % limb_bits;
         if (words >= rep_.size()) {
             rep_.clear();
         } else {
             rep_.erase(rep_.begin(), rep_.begin() + words);
             if (bits > 0) {
-                uint32_t prev = 0;
+                limb_type prev = 0;
                 for (size_t i = rep_.size() - 1; i != std::string::npos; --i) {
-                    uint32_t next = rep_[i] << (32 - bits);
+                    limb_type next = rep_[i] << (limb_bits - bits);
                     rep_[i] = (rep_[i] >> bits) | prev;
                     prev = next;
                 }
@@ -155,9 +1460,9 @@ namespace RS::Sci {
     }
 
     size_t MPN::bits() const noexcept {
-        size_t n = 32 * rep_.size();
+        size_t n = limb_bits * rep_.size();
         if (! rep_.empty())
-            n -= 32 - TL::bit_width(rep_.back());
+            n -= limb_bits - TL::bit_width(rep_.back());
         return n;
     }
 
@@ -169,11 +1474,7 @@ namespace RS::Sci {
     }
 
     size_t MPN::bytes() const noexcept {
-        if (rep_.empty())
-            return 0;
-        else
-            return 4 * (rep_.size() - 1) + size_t(rep_.back() > 0) + size_t(rep_.back() > size_t(0xff))
-                + size_t(rep_.back() > size_t(0xffff)) + size_t(rep_.back() > size_t(0xffffff));
+        return (bits() + 7) / 8;
     }
 
     int MPN::compare(const MPN& rhs) const noexcept {
@@ -186,45 +1487,113 @@ namespace RS::Sci {
     }
 
     bool MPN::get_bit(size_t i) const noexcept {
-        if (i < 32 * rep_.size())
-            return (rep_[i / 32] >> (i % 32)) & 1;
+        if (i < limb_bits * rep_.size())
+            return (rep_[i / limb_bits] >> (i % limb_bits)) & 1;
         else
             return false;
     }
 
     uint8_t MPN::get_byte(size_t i) const noexcept {
-        if (i < 4 * rep_.size())
-            return (rep_[i / 4] >> (i % 4 * 8)) & 0xff;
+        if (i < limb_bytes * rep_.size())
+            return (rep_[i / limb_bytes] >> (i % limb_bytes * 8)) & 0xff;
         else
             return 0;
     }
 
     void MPN::set_bit(size_t i, bool b) {
-        bool in_rep = i < 32 * rep_.size();
+        bool in_rep = i < limb_bits * rep_.size();
         if (b) {
             if (! in_rep)
-                rep_.resize(i / 32 + 1, 0);
-            rep_[i / 32] |= uint32_t(1) << (i % 32);
+                rep_.resize(i / limb_bits + 1, 0);
+            rep_[i / limb_bits] |= limb_type(1) << (i % limb_bits);
         } else if (in_rep) {
-            rep_[i / 32] &= ~ (uint32_t(1) << (i % 32));
+            rep_[i / limb_bits] &= ~ (limb_type(1) << (i % limb_bits));
             trim();
         }
     }
 
     void MPN::set_byte(size_t i, uint8_t b) {
-        if (i >= 4 * rep_.size())
-            rep_.resize(i / 4 + 1, 0);
-        rep_[i / 4] |= uint32_t(b) << (i % 4 * 8);
+        if (i >= limb_bytes * rep_.size())
+            rep_.resize(i / limb_bytes + 1, 0);
+        rep_[i / limb_bytes] |= limb_type(b) << (i % limb_bytes * 8);
         trim();
     }
 
     void MPN::flip_bit(size_t i) {
-        if (i >= 32 * rep_.size())
-            rep_.resize(i / 32 + 1, 0);
-        rep_[i / 32] ^= uint32_t(1) << (i % 32);
+        if (i >= limb_bits * rep_.size())
+            rep_.resize(i / limb_bits + 1, 0);
+        rep_[i / limb_bits] ^= limb_type(1) << (i % limb_bits);
         trim();
     }
 
+    size_t MPN::hash() const noexcept {
+        return size_t(hash_bytes(0));
+    }
+
+    size_t MPN::legacy_hash() const noexcept {
+
+        // Hash 32-bit pieces, so the result does not depend on the limb width
+
+        std::hash<uint32_t> piece_hash;
+        size_t h = 0;
+
+        #if RS_SCI_MPN_LIMB_BITS == 64
+            for (size_t i = 0; i < rep_.size(); ++i) {
+                h = Detail::mix_hashes(h, piece_hash(uint32_t(rep_[i])));
+                if (i + 1 < rep_.size() || (rep_[i] >> 32) != 0)
+                    h = Detail::mix_hashes(h, piece_hash(uint32_t(rep_[i] >> 32)));
+            }
+        #else
+            for (auto w: rep_)
+                h = Detail::mix_hashes(h, piece_hash(w));
+        #endif
+
+        return h;
+
+    }
+
+    // Hash the significant bytes of the value in little endian order, so
+    // the result does not depend on the limb width. Long values are hashed
+    // in pieces, each seeded with the hash of the one before, so a big
+    // endian machine can reorder them through a fixed size buffer. On a
+    // little endian machine (including every Windows target) the bytes are
+    // already in order in the limb array.
+
+    uint64_t MPN::hash_bytes(uint64_t seed) const noexcept {
+
+        constexpr size_t piece = 4096;
+
+        size_t n = bytes();
+        size_t i = 0;
+
+        #if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+            auto ptr = reinterpret_cast<const uint8_t*>(rep_.data());
+
+            do {
+                size_t len = std::min(piece, n - i);
+                seed = bulk_hash64(ptr + i, len, seed);
+                i += len;
+            } while (i < n);
+
+        #else
+
+            uint8_t buf[piece];
+
+            do {
+                size_t len = std::min(piece, n - i);
+                for (size_t j = 0; j < len; ++j)
+                    buf[j] = get_byte(i + j);
+                seed = bulk_hash64(buf, len, seed);
+                i += len;
+            } while (i < n);
+
+        #endif
+
+        return seed;
+
+    }
+
     MPN MPN::pow(const MPN& n) const {
         MPN x = *this, y = n, z = 1;
         while (y) {
@@ -247,22 +1616,19 @@ namespace RS::Sci {
         if (spec.lcmode() >= 'd' && spec.lcmode() <= 'g')
             return format_floating_point(static_cast<long double>(*this), spec);
 
-        MPN base;
-
-        switch (spec.lcmode()) {
-            case 'b':  base = 2; break;
-            case 'x':  base = 16; break;
-            default:   base = 10; break;
-        }
-
         spec.default_prec(1);
         auto xdigits = spec.mode() == 'X' ? Format::Detail::hex_digits_uc : Format::Detail::hex_digits_lc;
         std::string result;
 
-        for (MPN n = *this; n != 0 || result.size() < size_t(spec.prec()); n /= base)
-            result += xdigits[unsigned(n % base)];
+        switch (spec.lcmode()) {
+            case 'b':  result = words_to_binary_base(rep_, 1, xdigits); break;
+            case 'x':  result = words_to_binary_base(rep_, 4, xdigits); break;
+            default:   result = words_to_decimal(rep_); break;
+        }
+
+        if (result.size() < size_t(spec.prec()))
+            result.insert(0, size_t(spec.prec()) - result.size(), '0');
 
-        std::reverse(result.begin(), result.end());
         Format::Detail::expand_formatted_number(result, spec);
 
         return result;
@@ -295,7 +1661,7 @@ namespace RS::Sci {
 
     MPN MPN::read_be(const void* ptr, size_t n) {
         MPN result;
-        result.rep_.resize((n + 3) / 4);
+        result.rep_.resize((n + limb_bytes - 1) / limb_bytes);
         auto bp = static_cast<const uint8_t*>(ptr);
         for (size_t i = 0, j = n - 1; i < n; ++i, --j)
             result.set_byte(j, bp[i]);
@@ -305,7 +1671,7 @@ namespace RS::Sci {
 
     MPN MPN::read_le(const void* ptr, size_t n) {
         MPN result;
-        result.rep_.resize((n + 3) / 4);
+        result.rep_.resize((n + limb_bytes - 1) / limb_bytes);
         auto bp = static_cast<const uint8_t*>(ptr);
         for (size_t i = 0; i < n; ++i)
             result.set_byte(i, bp[i]);
@@ -315,71 +1681,125 @@ namespace RS::Sci {
 
     void MPN::do_divide(const MPN& x, const MPN& y, MPN& q, MPN& r) {
 
-        MPN quo, rem = x;
-
-        if (x >= y) {
-
-            size_t shift = x.bits() - y.bits();
-            MPN rsub = y;
-            rsub <<= shift;
-
-            if (rsub > x) {
-                --shift;
-                rsub >>= 1;
-            }
-
-            MPN qadd = 1;
-            qadd <<= shift;
+        if (! y)
+            throw std::domain_error("Division by zero");
 
-            while (qadd) {
-                if (rem >= rsub) {
-                    rem -= rsub;
-                    quo += qadd;
-                }
-                rsub >>= 1;
-                qadd >>= 1;
-            }
+        MPN quo, rem;
+        size_t m = x.rep_.size(), n = y.rep_.size();
 
+        if (x < y) {
+            rem = x;
+        } else if (n == 1) {
+            quo.rep_.resize(m);
+            Word rw = divide_by_word(quo.rep_.data(), x.rep_.data(), m, y.rep_[0]);
+            if (rw)
+                rem.rep_.push_back(rw);
+        } else {
+            divide_knuth(x.rep_.data(), m, y.rep_.data(), n, quo.rep_, rem.rep_);
         }
 
+        quo.trim();
+        rem.trim();
         q = std::move(quo);
         r = std::move(rem);
 
     }
 
-    void MPN::do_multiply(const MPN& x, const MPN& y, MPN& z) {
+    void MPN::do_multiply(const MPN& x, const MPN& y, MPN& z, MulAlgorithm alg) {
 
         if (! x || ! y) {
-
             z.rep_.clear();
-
         } else {
-
             size_t m = x.rep_.size(), n = y.rep_.size();
-            z.rep_.assign(m + n, 0);
-            uint64_t carry = 0;
+            if (&z == &x || &z == &y) {
+                Words product(m + n);
+                multiply_words(product.data(), x.rep_.data(), m, y.rep_.data(), n, alg);
+                z.rep_.swap(product);
+            } else {
+                z.rep_.resize(m + n);
+                multiply_words(z.rep_.data(), x.rep_.data(), m, y.rep_.data(), n, alg);
+            }
+            z.trim();
+        }
 
-            for (size_t k = 0; k <= m + n - 2; ++k) {
+    }
 
-                carry += uint64_t(z.rep_[k]);
-                z.rep_[k] = uint32_t(carry);
-                carry >>= 32;
-                size_t i_min = k < n ? 0 : k - n + 1;
-                size_t i_max = k < m ? k : m - 1;
+    void MPN::do_add(const MPN& x, const MPN& y, MPN& z) {
+        const MPN* a = &x;
+        const MPN* b = &y;
+        if (a->rep_.size() < b->rep_.size())
+            std::swap(a, b);
+        size_t m = a->rep_.size(), n = b->rep_.size();
+        z.rep_.resize(m);
+        Word carry = add_words(z.rep_.data(), a->rep_.data(), m, b->rep_.data(), n);
+        if (carry)
+            z.rep_.push_back(carry);
+    }
 
-                for (size_t i = i_min; i <= i_max; ++i) {
-                    uint64_t p = uint64_t(x.rep_[i]) * uint64_t(y.rep_[k - i]) + uint64_t(z.rep_[k]);
-                    z.rep_[k] = uint32_t(p);
-                    carry += uint32_t(p >> 32);
-                }
+    void MPN::do_subtract(const MPN& x, const MPN& y, MPN& z) {
+        size_t m = x.rep_.size(), n = std::min(m, y.rep_.size());
+        z.rep_.resize(m);
+        subtract_words(z.rep_.data(), x.rep_.data(), m, y.rep_.data(), n);
+        z.trim();
+    }
+
+    bool MPN::do_multiply_add(const MPN& x, const MPN& y, MPN& z, bool sub) {
+
+        if (! x || ! y)
+            return false;
+
+        if (&z == &x || &z == &y) {
+            MPN p;
+            do_multiply(x, y, p);
+            return do_multiply_add(p, 1, z, sub);
+        }
 
+        const MPN* a = &x;
+        const MPN* b = &y;
+        if (a->rep_.size() < b->rep_.size())
+            std::swap(a, b);
+        size_t m = a->rep_.size(), n = b->rep_.size();
+        size_t k = std::max(z.rep_.size(), m + n) + 1;
+        z.rep_.resize(k);
+        Word* zp = z.rep_.data();
+        const Word* xp = a->rep_.data();
+        const Word* yp = b->rep_.data();
+
+        if (n < karatsuba_threshold) {
+
+            // Accumulate one row of partial products at a time
+
+            for (size_t j = 0; j < n; ++j) {
+                if (sub) {
+                    Word w = subtract_multiple(zp + j, xp, m, yp[j]);
+                    subtract_in_place(zp + j + m, k - j - m, &w, 1);
+                } else {
+                    Word w = add_multiple(zp + j, xp, m, yp[j]);
+                    add_in_place(zp + j + m, k - j - m, &w, 1);
+                }
             }
 
-            z.rep_[m + n - 1] = uint32_t(carry);
-            z.trim();
+        } else {
+
+            Words product(m + n);
+            multiply_words(product.data(), xp, m, yp, n);
+            if (sub)
+                subtract_in_place(zp, k, product.data(), m + n);
+            else
+                add_in_place(zp, k, product.data(), m + n);
 
         }
 
+        // Both z and the product fit in k-1 words, so after a subtraction
+        // the top word is only nonzero if the result wrapped around; its
+        // two's complement is then the magnitude of the negative result
+
+        bool negative = sub && zp[k - 1] != 0;
+        if (negative)
+            negate_words(zp, k);
+        z.trim();
+        return negative;
+
     }
 
     void MPN::init(std::string_view s, int base) {
@@ -405,7 +1825,6 @@ namespace RS::Sci {
                 ptr += 2;
         }
 
-        MPN nbase = base;
         int digit = 0;
         int (*get_digit)(char c);
 
@@ -415,16 +1834,26 @@ namespace RS::Sci {
             get_digit = [] (char c) noexcept { return c >= '0' && c <= '9' ? int(c - '0') :
                 c >= 'A' && c <= 'Z' ? int(c - 'A') + 10 : c >= 'a' && c <= 'z' ? int(c - 'a') + 10 : 64; };
 
+        std::vector<uint8_t> digits;
+        digits.reserve(end - ptr);
+
         for (; ptr != end; ++ptr) {
             if (*ptr == '\'')
                 continue;
             digit = get_digit(*ptr);
             if (digit >= base)
                 throw std::invalid_argument(format("Invalid base {0} integer: {1:q}", base, s));
-            *this *= nbase;
-            *this += digit;
+            if (digit != 0 || ! digits.empty())
+                digits.push_back(uint8_t(digit));
         }
 
+        int log2_base = TL::bit_width(unsigned(base)) - 1;
+
+        if (base == 1 << log2_base)
+            rep_ = binary_base_to_words(digits, log2_base);
+        else
+            rep_ = RadixParser(base).parse(digits.data(), digits.size());
+
     }
 
     void MPN::trim() noexcept {
@@ -437,28 +1866,7 @@ namespace RS::Sci {
     // Signed integer class
 
     MPZ& MPZ::operator+=(const MPZ& rhs) {
-        if (! rhs.mag_) {
-            // do nothing
-        } else if (! mag_) {
-            mag_ = rhs.mag_;
-            neg_ = rhs.neg_;
-        } else if (neg_ == rhs.neg_) {
-            mag_ += rhs.mag_;
-        } else {
-            switch (mag_.compare(rhs.mag_)) {
-                case -1:
-                    mag_ = rhs.mag_ - mag_;
-                    neg_ = ! neg_;
-                    break;
-                case 1:
-                    mag_ -= rhs.mag_;
-                    break;
-                default:
-                    mag_ = {};
-                    neg_ = false;
-                    break;
-            }
-        }
+        do_add(*this, rhs, *this, false);
         return *this;
     }
 
@@ -469,6 +1877,15 @@ namespace RS::Sci {
         return neg_ ? - c : c;
     }
 
+    size_t MPZ::hash() const noexcept {
+        static constexpr uint64_t negative_seed = 0x9e37'79b9'7f4a'7c15ull;
+        return size_t(mag_.hash_bytes(neg_ ? negative_seed : 0));
+    }
+
+    size_t MPZ::legacy_hash() const noexcept {
+        return Detail::mix_hashes(mag_.legacy_hash(), std::hash<bool>()(neg_));
+    }
+
     MPZ MPZ::pow(const MPZ& n) const {
         MPZ z;
         z.mag_ = mag_.pow(n.mag_);
@@ -511,6 +1928,30 @@ namespace RS::Sci {
         neg_ &= bool(mag_);
     }
 
+    void MPZ::do_add(const MPZ& x, const MPZ& y, MPZ& z, bool sub) {
+        bool xneg = x.neg_, yneg = y.neg_ != sub;
+        if (xneg == yneg) {
+            MPN::do_add(x.mag_, y.mag_, z.mag_);
+            z.neg_ = xneg;
+        } else if (x.mag_ < y.mag_) {
+            MPN::do_subtract(y.mag_, x.mag_, z.mag_);
+            z.neg_ = yneg;
+        } else {
+            MPN::do_subtract(x.mag_, y.mag_, z.mag_);
+            z.neg_ = xneg;
+        }
+        z.neg_ &= bool(z.mag_);
+    }
+
+    void MPZ::do_multiply_add(const MPZ& x, const MPZ& y, MPZ& z, bool sub) {
+        bool pneg = (x.neg_ != y.neg_) != sub;
+        if (! z.mag_)
+            z.neg_ = pneg;
+        if (MPN::do_multiply_add(x.mag_, y.mag_, z.mag_, z.neg_ != pneg))
+            z.neg_ = ! z.neg_;
+        z.neg_ &= bool(z.mag_);
+    }
+
     void MPZ::do_divide(const MPZ& x, const MPZ& y, MPZ& q, MPZ& r) {
         MPZ quo, rem;
         MPN::do_divide(x.mag_, y.mag_, quo.mag_, rem.mag_);
@@ -530,4 +1971,290 @@ namespace RS::Sci {
         z.neg_ = bool(x) && bool(y) && x.neg_ != y.neg_;
     }
 
+    // Modular arithmetic
+
+    MontgomeryContext::MontgomeryContext(const MPN& m):
+    mod_(m) {
+        if (m.is_even())
+            throw std::invalid_argument("Montgomery modulus must be odd: " + m.str());
+        size_t n = m.rep_.size();
+        inv_ = montgomery_inverse(m.rep_[0]);
+        r2_ = 1;
+        r2_ <<= 2 * n * MPN::limb_bits;
+        r2_ %= m;
+        r2_.rep_.resize(n, 0);
+    }
+
+    MPN MontgomeryContext::multiply(const MPN& x, const MPN& y) const {
+        size_t n = mod_.rep_.size();
+        MPN z = padded(x), b = padded(y);
+        Words t(n + 2);
+        montgomery_multiply(z.rep_.data(), z.rep_.data(), b.rep_.data(), mod_.rep_.data(), n, inv_, t.data());
+        montgomery_multiply(z.rep_.data(), z.rep_.data(), r2_.rep_.data(), mod_.rep_.data(), n, inv_, t.data());
+        z.trim();
+        return z;
+    }
+
+    MPN MontgomeryContext::pow(const MPN& x, const MPN& n) const {
+
+        if (mod_ == 1)
+            return 0;
+        if (! n)
+            return 1;
+
+        size_t k = mod_.rep_.size();
+        const Word* m = mod_.rep_.data();
+        Words t(k + 2);
+
+        // Odd powers x^1, x^3, ... x^(2^w-1) in Montgomery form, stored
+        // contiguously k words apart
+
+        int w = window_bits(n.bits());
+        size_t table_size = size_t(1) << (w - 1);
+        Words table(k * table_size);
+        MPN z = padded(x);
+        Words& acc = z.rep_;
+        montgomery_multiply(table.data(), acc.data(), r2_.rep_.data(), m, k, inv_, t.data());
+        montgomery_multiply(acc.data(), table.data(), table.data(), m, k, inv_, t.data());
+        for (size_t i = 1; i < table_size; ++i)
+            montgomery_multiply(table.data() + i * k, table.data() + (i - 1) * k, acc.data(), m, k, inv_, t.data());
+
+        // Scan the exponent from the top, squaring for every bit and
+        // multiplying by a table entry for each window ending in a 1 bit
+
+        bool started = false;
+        ptrdiff_t i = ptrdiff_t(n.bits()) - 1;
+
+        while (i >= 0) {
+            if (! n.get_bit(i)) {
+                if (started)
+                    montgomery_multiply(acc.data(), acc.data(), acc.data(), m, k, inv_, t.data());
+                --i;
+                continue;
+            }
+            ptrdiff_t j = std::max(i - w + 1, ptrdiff_t(0));
+            while (! n.get_bit(j))
+                ++j;
+            size_t value = 0;
+            for (ptrdiff_t b = i; b >= j; --b)
+                value = 2 * value + size_t(n.get_bit(b));
+            const Word* entry = table.data() + (value / 2) * k;
+            if (started) {
+                for (ptrdiff_t b = i; b >= j; --b)
+                    montgomery_multiply(acc.data(), acc.data(), acc.data(), m, k, inv_, t.data());
+                montgomery_multiply(acc.data(), acc.data(), entry, m, k, inv_, t.data());
+            } else {
+                std::copy(entry, entry + k, acc.data());
+                started = true;
+            }
+            i = j - 1;
+        }
+
+        // Multiplying by 1 converts back from Montgomery form
+
+        Words one(k, 0);
+        one[0] = 1;
+        montgomery_multiply(acc.data(), acc.data(), one.data(), m, k, inv_, t.data());
+        z.trim();
+        return z;
+
+    }
+
+    MPN MontgomeryContext::padded(const MPN& x) const {
+        MPN z = x < mod_ ? x : x % mod_;
+        z.rep_.resize(mod_.rep_.size(), 0);
+        return z;
+    }
+
+    MPN powmod(const MPN& x, const MPN& n, const MPN& m) {
+        if (! m)
+            throw std::domain_error("Division by zero");
+        if (m.is_odd())
+            return MontgomeryContext(m).pow(x, n);
+        MPN a = x % m, y = n, z = 1;
+        while (y) {
+            if (y.is_odd()) {
+                z *= a;
+                z %= m;
+            }
+            a *= a;
+            a %= m;
+            y >>= 1;
+        }
+        return z % m;
+    }
+
+    MPZ powmod(const MPZ& x, const MPZ& n, const MPZ& m) {
+        if (n.neg_)
+            throw std::domain_error("Negative exponent in modular power");
+        MPN a(x % m), mod(m.abs());
+        return powmod(a, n.mag_, mod);
+    }
+
+    // Primality testing
+
+    bool is_prime(const MPN& n) {
+
+        if (n.bits() <= 64)
+            return Detail::is_prime64(uint64_t(n));
+        if (n.is_even())
+            return false;
+
+        bool small_factor = false;
+        find_small_factors(n, [&small_factor] (uint64_t) { small_factor = true; return false; });
+        if (small_factor)
+            return false;
+
+        // Baillie-PSW: a strong probable prime test to base 2, followed by
+        // a strong Lucas probable prime test
+
+        MontgomeryContext context(n);
+        MPN n1 = n - 1, d = n1;
+        size_t s = 0;
+        for (; d.is_even(); d >>= 1)
+            ++s;
+        MPN x = context.pow(2, d);
+        if (x != 1 && x != n1) {
+            size_t r = 1;
+            for (; r < s && x != n1; ++r)
+                x = context.multiply(x, x);
+            if (x != n1)
+                return false;
+        }
+
+        return is_strong_lucas_probable_prime(n);
+
+    }
+
+    // Prime factorization
+
+    // Brent's variant of Pollard's rho algorithm, for odd composite n of
+    // more than 64 bits. This works on the Montgomery form of the sequence
+    // x -> x^2+c; this is a different sequence, but it is still a
+    // polynomial map mod any factor of n, which is all the algorithm needs.
+    // Returns n on failure.
+
+    MPN MPN::do_pollard_brent(const MPN& n, limb_type c) {
+
+        static constexpr size_t batch = 128;
+
+        size_t k = n.rep_.size();
+        const Word* m = n.rep_.data();
+        Word minv = montgomery_inverse(m[0]);
+        Words x(k), y(k), ys(k), d(k), t(k + 2);
+        MPN q = 1, g = 1;
+        q.rep_.resize(k);
+        y[0] = 2;
+
+        auto f = [&] (Words& z) {
+            montgomery_multiply(z.data(), z.data(), z.data(), m, k, minv, t.data());
+            if (add_in_place(z.data(), k, &c, 1) != 0 || compare_words(z.data(), m, k) >= 0)
+                subtract_in_place(z.data(), k, m, k);
+        };
+
+        auto diff = [&] (const Words& a, const Words& b) {
+            if (compare_words(a.data(), b.data(), k) >= 0)
+                subtract_words(d.data(), a.data(), k, b.data(), k);
+            else
+                subtract_words(d.data(), b.data(), k, a.data(), k);
+        };
+
+        auto gcd_with_n = [&] (const Words& a) {
+            MPN z;
+            z.rep_ = a;
+            z.trim();
+            return gcd(n, z);
+        };
+
+        for (size_t r = 1; g == 1; r *= 2) {
+            x = y;
+            for (size_t i = 0; i < r; ++i)
+                f(y);
+            for (size_t j = 0; j < r && g == 1; j += batch) {
+                ys = y;
+                for (size_t i = 0, e = std::min(batch, r - j); i < e; ++i) {
+                    f(y);
+                    diff(x, y);
+                    montgomery_multiply(q.rep_.data(), q.rep_.data(), d.data(), m, k, minv, t.data());
+                }
+                g = gcd_with_n(q.rep_);
+            }
+        }
+
+        // If the batch overshot, step through it again one at a time
+
+        if (g == n) {
+            do {
+                f(ys);
+                diff(x, ys);
+                g = gcd_with_n(d);
+            } while (g == 1);
+        }
+
+        return g;
+
+    }
+
+    std::vector<MPN> prime_factors(const MPN& n) {
+
+        std::vector<MPN> factors;
+        if (n < 2)
+            return factors;
+        if (n.bits() <= 64) {
+            std::vector<uint64_t> factors64;
+            Detail::factorize64(uint64_t(n), factors64);
+            factors.assign(factors64.begin(), factors64.end());
+            return factors;
+        }
+
+        // Strip small factors, then split the remaining cofactors with
+        // Pollard-Brent until each one is prime
+
+        MPN a = n;
+        for (; a.is_even(); a >>= 1)
+            factors.push_back(2);
+        find_small_factors(a, [&a,&factors] (uint64_t p) {
+            do {
+                a /= p;
+                factors.push_back(p);
+            } while (a % p == 0);
+            return true;
+        });
+
+        std::vector<MPN> pending;
+        if (a > 1)
+            pending.push_back(std::move(a));
+
+        while (! pending.empty()) {
+            a = std::move(pending.back());
+            pending.pop_back();
+            if (a.bits() <= 64) {
+                std::vector<uint64_t> factors64;
+                Detail::factorize64(uint64_t(a), factors64);
+                factors.insert(factors.end(), factors64.begin(), factors64.end());
+            } else if (is_prime(a)) {
+                factors.push_back(std::move(a));
+            } else {
+                MPN d = a;
+                for (MPN::limb_type c = 1; d == a; ++c)
+                    d = MPN::do_pollard_brent(a, c);
+                pending.push_back(a / d);
+                pending.push_back(std::move(d));
+            }
+        }
+
+        std::sort(factors.begin(), factors.end());
+
+        return factors;
+
+    }
+
+    std::vector<MPZ> prime_factors(const MPZ& n) {
+        std::vector<MPZ> factors;
+        if (! n.neg_)
+            for (auto& p: prime_factors(n.mag_))
+                factors.push_back(std::move(p));
+        return factors;
+    }
+
 }
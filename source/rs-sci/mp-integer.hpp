@@ -1,13 +1,16 @@
 #pragma once
 
+#include "rs-sci/hash.hpp"
 #include "rs-sci/random.hpp"
 #include "rs-sci/rational.hpp"
 #include "rs-format/format.hpp"
 #include "rs-tl/binary.hpp"
+#include "rs-tl/enum.hpp"
 #include "rs-tl/types.hpp"
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <initializer_list>
 #include <ostream>
 #include <string>
 #include <string_view>
@@ -15,14 +18,195 @@
 #include <utility>
 #include <vector>
 
+// Width of the MPN limbs (the words of the internal representation), 32 or
+// 64 bits. The default is 64 where the compiler supports 128-bit integers
+// for the double width products.
+
+#ifndef RS_SCI_MPN_LIMB_BITS
+    #ifdef __SIZEOF_INT128__
+        #define RS_SCI_MPN_LIMB_BITS 64
+    #else
+        #define RS_SCI_MPN_LIMB_BITS 32
+    #endif
+#endif
+
+#if RS_SCI_MPN_LIMB_BITS != 32 && RS_SCI_MPN_LIMB_BITS != 64
+    #error "RS_SCI_MPN_LIMB_BITS must be 32 or 64"
+#endif
+
 namespace RS::Sci {
 
+    RS_DEFINE_ENUM_CLASS(MulAlgorithm, int, 0,
+        automatic,   // Choose by operand size
+        schoolbook,  // Long multiplication, O(n^2)
+        karatsuba,   // Karatsuba, O(n^1.58)
+        toom3,       // Toom-Cook 3-way, O(n^1.46)
+        ntt          // Number theoretic transform, O(n log n)
+    )
+
+    // Limb storage for MPN: a vector of trivially copyable values with
+    // inline space for N elements, only allocating when it grows beyond that
+
+    namespace Detail {
+
+        template <typename T, size_t N>
+        class LimbVector {
+
+        public:
+
+            static_assert(std::is_trivially_copyable_v<T>);
+
+            using const_iterator = const T*;
+            using iterator = T*;
+            using value_type = T;
+
+            LimbVector() noexcept {}
+            explicit LimbVector(size_t n, T t = T()) { resize(n, t); }
+            LimbVector(const T* first, const T* last) { assign(first, last); }
+            LimbVector(std::initializer_list<T> list) { assign(list.begin(), list.end()); }
+            LimbVector(const LimbVector& v) { assign(v.begin(), v.end()); }
+            LimbVector(LimbVector&& v) noexcept { take(v); }
+            ~LimbVector() noexcept { release(); }
+            LimbVector& operator=(const LimbVector& v) { if (&v != this) assign(v.begin(), v.end()); return *this; }
+            LimbVector& operator=(LimbVector&& v) noexcept { if (&v != this) { release(); take(v); } return *this; }
+
+            T& operator[](size_t i) noexcept { return ptr_[i]; }
+            const T& operator[](size_t i) const noexcept { return ptr_[i]; }
+
+            iterator begin() noexcept { return ptr_; }
+            const_iterator begin() const noexcept { return ptr_; }
+            iterator end() noexcept { return ptr_ + size_; }
+            const_iterator end() const noexcept { return ptr_ + size_; }
+            T& front() noexcept { return ptr_[0]; }
+            const T& front() const noexcept { return ptr_[0]; }
+            T& back() noexcept { return ptr_[size_ - 1]; }
+            const T& back() const noexcept { return ptr_[size_ - 1]; }
+            T* data() noexcept { return ptr_; }
+            const T* data() const noexcept { return ptr_; }
+
+            size_t capacity() const noexcept { return cap_; }
+            bool empty() const noexcept { return size_ == 0; }
+            bool is_inline() const noexcept { return ptr_ == local_; }
+            size_t size() const noexcept { return size_; }
+
+            void assign(size_t n, T t) { size_ = 0; resize(n, t); }
+            void assign(const T* first, const T* last);
+            void clear() noexcept { size_ = 0; }
+            iterator erase(iterator first, iterator last) noexcept;
+            iterator insert(iterator pos, size_t n, T t);
+            void pop_back() noexcept { --size_; }
+            void push_back(T t) { reserve(size_ + 1); ptr_[size_++] = t; }
+            void reserve(size_t n);
+            void resize(size_t n, T t = T());
+            void swap(LimbVector& v) noexcept;
+
+        private:
+
+            T* ptr_ = local_;
+            size_t size_ = 0;
+            size_t cap_ = N;
+            T local_[N];
+
+            void release() noexcept { if (! is_inline()) delete[] ptr_; ptr_ = local_; size_ = 0; cap_ = N; }
+            void take(LimbVector& v) noexcept;
+
+        };
+
+        template <typename T, size_t N>
+        void LimbVector<T, N>::assign(const T* first, const T* last) {
+            size_t n = last - first;
+            size_ = 0;
+            reserve(n);
+            std::copy(first, last, ptr_);
+            size_ = n;
+        }
+
+        template <typename T, size_t N>
+        T* LimbVector<T, N>::erase(iterator first, iterator last) noexcept {
+            std::copy(last, end(), first);
+            size_ -= last - first;
+            return first;
+        }
+
+        template <typename T, size_t N>
+        T* LimbVector<T, N>::insert(iterator pos, size_t n, T t) {
+            size_t i = pos - ptr_;
+            reserve(size_ + n);
+            std::copy_backward(ptr_ + i, ptr_ + size_, ptr_ + size_ + n);
+            std::fill_n(ptr_ + i, n, t);
+            size_ += n;
+            return ptr_ + i;
+        }
+
+        template <typename T, size_t N>
+        void LimbVector<T, N>::reserve(size_t n) {
+            if (n <= cap_)
+                return;
+            size_t new_cap = std::max(n, 2 * cap_);
+            T* new_ptr = new T[new_cap];
+            std::copy(ptr_, ptr_ + size_, new_ptr);
+            if (! is_inline())
+                delete[] ptr_;
+            ptr_ = new_ptr;
+            cap_ = new_cap;
+        }
+
+        template <typename T, size_t N>
+        void LimbVector<T, N>::resize(size_t n, T t) {
+            if (n > size_) {
+                reserve(n);
+                std::fill(ptr_ + size_, ptr_ + n, t);
+            }
+            size_ = n;
+        }
+
+        template <typename T, size_t N>
+        void LimbVector<T, N>::swap(LimbVector& v) noexcept {
+            if (&v == this)
+                return;
+            if (! is_inline() && ! v.is_inline()) {
+                std::swap(ptr_, v.ptr_);
+                std::swap(size_, v.size_);
+                std::swap(cap_, v.cap_);
+                return;
+            }
+            LimbVector temp(std::move(v));
+            v = std::move(*this);
+            *this = std::move(temp);
+        }
+
+        template <typename T, size_t N>
+        void LimbVector<T, N>::take(LimbVector& v) noexcept {
+            if (v.is_inline()) {
+                std::copy(v.ptr_, v.ptr_ + v.size_, local_);
+                ptr_ = local_;
+                cap_ = N;
+            } else {
+                ptr_ = v.ptr_;
+                cap_ = v.cap_;
+            }
+            size_ = v.size_;
+            v.ptr_ = v.local_;
+            v.size_ = 0;
+            v.cap_ = N;
+        }
+
+    }
+
     // Unsigned integer class
 
     class MPN:
     public TL::TotalOrder<MPN> {
     public:
 
+        #if RS_SCI_MPN_LIMB_BITS == 64
+            using limb_type = uint64_t;
+        #else
+            using limb_type = uint32_t;
+        #endif
+
+        static constexpr int limb_bits = RS_SCI_MPN_LIMB_BITS;
+
         MPN() = default;
         MPN(uint64_t x);
         explicit MPN(std::string_view s, int base = 0) { init(s, base); }
@@ -56,7 +240,8 @@ namespace RS::Sci {
         void set_bit(size_t i, bool b = true);
         void set_byte(size_t i, uint8_t b);
         void flip_bit(size_t i);
-        size_t hash() const noexcept { return hash_mix(rep_); }
+        size_t hash() const noexcept;
+        size_t legacy_hash() const noexcept;
         bool is_even() const noexcept { return rep_.empty() || (rep_.front() & 1) == 0; }
         bool is_odd() const noexcept { return ! is_even(); }
         MPN pow(const MPN& n) const;
@@ -74,25 +259,45 @@ namespace RS::Sci {
         friend MPN operator%(const MPN& lhs, const MPN& rhs) { MPN q, r; MPN::do_divide(lhs, rhs, q, r); return r; }
 
         friend std::pair<MPN, MPN> divide(const MPN& lhs, const MPN& rhs) { MPN q, r; MPN::do_divide(lhs, rhs, q, r); return {q, r}; }
+        friend MPN multiply(const MPN& lhs, const MPN& rhs, MulAlgorithm alg) { MPN z; MPN::do_multiply(lhs, rhs, z, alg); return z; }
+
+        friend void add(MPN& z, const MPN& x, const MPN& y) { MPN::do_add(x, y, z); }
+        friend void subtract(MPN& z, const MPN& x, const MPN& y) { MPN::do_subtract(x, y, z); }
+        friend void multiply(MPN& z, const MPN& x, const MPN& y) { MPN::do_multiply(x, y, z); }
+        friend void addmul(MPN& z, const MPN& x, const MPN& y) { MPN::do_multiply_add(x, y, z, false); }
+        friend void submul(MPN& z, const MPN& x, const MPN& y) { MPN::do_multiply_add(x, y, z, true); }
+
+        friend bool is_prime(const MPN& n);
+        friend std::vector<MPN> prime_factors(const MPN& n);
+        friend MPN powmod(const MPN& x, const MPN& n, const MPN& m);
 
     private:
 
+        friend class MontgomeryContext;
         friend class MPZ;
 
-        static constexpr auto mask32 = ~ uint32_t(0);
+        static constexpr size_t limb_bytes = limb_bits / 8;
+        static constexpr auto limb_max = ~ limb_type(0);
 
-        std::vector<uint32_t> rep_; // Least significant word first
+        static constexpr size_t inline_limbs = 256 / limb_bits;
 
+        Detail::LimbVector<limb_type, inline_limbs> rep_; // Least significant limb first
+
+        uint64_t hash_bytes(uint64_t seed) const noexcept;
         void init(std::string_view s, int base);
         void trim() noexcept;
 
+        static void do_add(const MPN& x, const MPN& y, MPN& z);
         static void do_divide(const MPN& x, const MPN& y, MPN& q, MPN& r);
-        static void do_multiply(const MPN& x, const MPN& y, MPN& z);
+        static void do_multiply(const MPN& x, const MPN& y, MPN& z, MulAlgorithm alg = MulAlgorithm::automatic);
+        static bool do_multiply_add(const MPN& x, const MPN& y, MPN& z, bool sub);
+        static MPN do_pollard_brent(const MPN& n, limb_type c);
+        static void do_subtract(const MPN& x, const MPN& y, MPN& z);
 
     };
 
-        inline MPN operator+(const MPN& lhs, const MPN& rhs) { auto z = lhs; z += rhs; return z; }
-        inline MPN operator-(const MPN& lhs, const MPN& rhs) { auto z = lhs; z -= rhs; return z; }
+        inline MPN operator+(const MPN& lhs, const MPN& rhs) { MPN z; add(z, lhs, rhs); return z; }
+        inline MPN operator-(const MPN& lhs, const MPN& rhs) { MPN z; subtract(z, lhs, rhs); return z; }
         inline MPN operator&(const MPN& lhs, const MPN& rhs) { auto z = lhs; z &= rhs; return z; }
         inline MPN operator|(const MPN& lhs, const MPN& rhs) { auto z = lhs; z |= rhs; return z; }
         inline MPN operator^(const MPN& lhs, const MPN& rhs) { auto z = lhs; z ^= rhs; return z; }
@@ -115,7 +320,7 @@ namespace RS::Sci {
                         break;
                     t += T(w) << bit;
                 }
-                bit += 32;
+                bit += limb_bits;
             }
             return t;
         }
@@ -144,14 +349,15 @@ namespace RS::Sci {
         MPZ& operator--() { return *this -= 1; }
         MPZ operator--(int) { auto x = *this; --*this; return x; }
         MPZ& operator+=(const MPZ& rhs);
-        MPZ& operator-=(const MPZ& rhs) { return *this += - rhs; }
+        MPZ& operator-=(const MPZ& rhs) { MPZ::do_add(*this, rhs, *this, true); return *this; }
         MPZ& operator*=(const MPZ& rhs) { MPZ z; do_multiply(*this, rhs, z); std::swap(*this, z); return *this; }
         MPZ& operator/=(const MPZ& rhs) { MPZ q, r; do_divide(*this, rhs, q, r); std::swap(*this, q); return *this; }
         MPZ& operator%=(const MPZ& rhs) { MPZ q, r; do_divide(*this, rhs, q, r); std::swap(*this, r); return *this; }
 
         MPN abs() const { return mag_; }
         int compare(const MPZ& rhs) const noexcept;
-        size_t hash() const noexcept { return hash_mix(mag_, neg_); }
+        size_t hash() const noexcept;
+        size_t legacy_hash() const noexcept;
         bool is_even() const noexcept { return mag_.is_even(); }
         bool is_odd() const noexcept { return mag_.is_odd(); }
         MPZ pow(const MPZ& n) const;
@@ -165,6 +371,16 @@ namespace RS::Sci {
         friend MPZ operator%(const MPZ& lhs, const MPZ& rhs) { MPZ q, r; MPZ::do_divide(lhs, rhs, q, r); return r; }
         friend std::pair<MPZ, MPZ> divide(const MPZ& lhs, const MPZ& rhs) { MPZ q, r; MPZ::do_divide(lhs, rhs, q, r); return {q, r}; }
 
+        friend void add(MPZ& z, const MPZ& x, const MPZ& y) { MPZ::do_add(x, y, z, false); }
+        friend void subtract(MPZ& z, const MPZ& x, const MPZ& y) { MPZ::do_add(x, y, z, true); }
+        friend void multiply(MPZ& z, const MPZ& x, const MPZ& y) { MPZ::do_multiply(x, y, z); }
+        friend void addmul(MPZ& z, const MPZ& x, const MPZ& y) { MPZ::do_multiply_add(x, y, z, false); }
+        friend void submul(MPZ& z, const MPZ& x, const MPZ& y) { MPZ::do_multiply_add(x, y, z, true); }
+
+        friend bool is_prime(const MPZ& n) { return ! n.neg_ && is_prime(n.mag_); }
+        friend std::vector<MPZ> prime_factors(const MPZ& n);
+        friend MPZ powmod(const MPZ& x, const MPZ& n, const MPZ& m);
+
     private:
 
         MPN mag_;
@@ -172,15 +388,17 @@ namespace RS::Sci {
 
         void init(std::string_view s, int base);
 
+        static void do_add(const MPZ& x, const MPZ& y, MPZ& z, bool sub);
         static void do_divide(const MPZ& x, const MPZ& y, MPZ& q, MPZ& r);
         static void do_multiply(const MPZ& x, const MPZ& y, MPZ& z);
+        static void do_multiply_add(const MPZ& x, const MPZ& y, MPZ& z, bool sub);
 
     };
 
         using MPQ = Ratio<MPZ>;
 
-        inline MPZ operator+(const MPZ& lhs, const MPZ& rhs) { auto z = lhs; z += rhs; return z; }
-        inline MPZ operator-(const MPZ& lhs, const MPZ& rhs) { auto z = lhs; z -= rhs; return z; }
+        inline MPZ operator+(const MPZ& lhs, const MPZ& rhs) { MPZ z; add(z, lhs, rhs); return z; }
+        inline MPZ operator-(const MPZ& lhs, const MPZ& rhs) { MPZ z; subtract(z, lhs, rhs); return z; }
         inline bool operator==(const MPZ& lhs, const MPZ& rhs) noexcept { return lhs.compare(rhs) == 0; }
         inline bool operator<(const MPZ& lhs, const MPZ& rhs) noexcept { return lhs.compare(rhs) == -1; }
         inline std::string to_string(const MPZ& x) { return x.str(); }
@@ -194,6 +412,29 @@ namespace RS::Sci {
             return t;
         }
 
+    // Modular arithmetic
+
+    class MontgomeryContext {
+
+    public:
+
+        MontgomeryContext() = default;
+        explicit MontgomeryContext(const MPN& m);
+
+        const MPN& modulus() const noexcept { return mod_; }
+        MPN multiply(const MPN& x, const MPN& y) const;
+        MPN pow(const MPN& x, const MPN& n) const;
+
+    private:
+
+        MPN mod_;
+        MPN r2_; // R^2 mod m, padded to the length of m
+        MPN::limb_type inv_ = 0; // -1/m mod 2^limb_bits
+
+        MPN padded(const MPN& x) const; // x mod m, padded to the length of m
+
+    };
+
     // Literals
 
     namespace Literals {
@@ -0,0 +1,863 @@
+#include "rs-sci/prime.hpp"
+#include "rs-tl/binary.hpp"
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <utility>
+
+namespace RS::Sci {
+
+    namespace {
+
+        // The sieve only stores numbers coprime to 30, using one byte for
+        // each block of 30 integers, with one bit for each residue
+
+        constexpr uint64_t wheel_residues[8] = { 1, 7, 11, 13, 17, 19, 23, 29 };
+        constexpr uint64_t wheel_gaps[8] = { 6, 4, 2, 4, 2, 4, 6, 2 };
+
+        struct WheelTables {
+            int8_t index[30] = {};    // Wheel index of each residue, or -1
+            uint8_t mask[8][8] = {};  // [p][k] = bit for p*k mod 30
+            uint8_t carry[8][8] = {}; // [p][k] = extra bytes from p*k to p*(k+gap)
+            uint8_t lowest_bit[256] = {};
+            uint8_t bit_count[256] = {};
+        };
+
+        constexpr WheelTables make_wheel_tables() noexcept {
+            WheelTables t;
+            for (auto& i: t.index)
+                i = -1;
+            for (int i = 0; i < 8; ++i)
+                t.index[wheel_residues[i]] = int8_t(i);
+            for (int i = 0; i < 8; ++i) {
+                auto r = wheel_residues[i];
+                for (int j = 0; j < 8; ++j) {
+                    auto w = wheel_residues[j];
+                    t.mask[i][j] = uint8_t(1 << t.index[r * w % 30]);
+                    t.carry[i][j] = uint8_t(r * (w + wheel_gaps[j]) / 30 - r * w / 30);
+                }
+            }
+            for (int i = 1; i < 256; ++i) {
+                for (int j = 7; j >= 0; --j) {
+                    if (i & (1 << j)) {
+                        t.lowest_bit[i] = uint8_t(j);
+                        ++t.bit_count[i];
+                    }
+                }
+            }
+            return t;
+        }
+
+        constexpr WheelTables wheel = make_wheel_tables();
+
+        constexpr uint64_t min_sieve_limit = uint64_t(1) << 24;
+
+        uint64_t isqrt(uint64_t n) noexcept {
+            auto r = uint64_t(std::sqrt(double(n)));
+            while (r > 0 && r > n / r)
+                --r;
+            while (r + 1 <= n / (r + 1))
+                ++r;
+            return r;
+        }
+
+        uint64_t icbrt(uint64_t n) noexcept {
+            auto r = uint64_t(std::cbrt(double(n)));
+            while (r > 0 && r > n / r / r)
+                --r;
+            while ((r + 1) <= n / (r + 1) / (r + 1))
+                ++r;
+            return r;
+        }
+
+        // Table of pi(n) for n up to a limit, with one bit for each odd
+        // number, and a running count of primes before each 64-bit word
+
+        class PrimePiTable {
+        public:
+            explicit PrimePiTable(uint64_t limit);
+            uint64_t limit() const noexcept { return limit_; }
+            uint64_t operator()(uint64_t n) const noexcept;
+        private:
+            std::vector<uint64_t> bits_;
+            std::vector<uint64_t> counts_;
+            uint64_t limit_;
+        };
+
+            PrimePiTable::PrimePiTable(uint64_t limit):
+            bits_(size_t(limit / 128 + 1), 0),
+            counts_(bits_.size(), 0),
+            limit_(limit) {
+                PrimeSieve sieve(3, limit);
+                std::vector<uint64_t> primes;
+                while (sieve.next(primes))
+                    for (auto p: primes)
+                        bits_[size_t(p / 128)] |= uint64_t(1) << (p / 2 % 64);
+                for (size_t i = 1; i < bits_.size(); ++i)
+                    counts_[i] = counts_[i - 1] + uint64_t(TL::popcount(bits_[i - 1]));
+            }
+
+            uint64_t PrimePiTable::operator()(uint64_t n) const noexcept {
+                if (n < 2)
+                    return 0;
+                uint64_t i = (n - 1) / 2; // Index of the largest odd number <= n
+                uint64_t bit = i % 64;
+                uint64_t mask = bit == 63 ? ~ uint64_t(0) : (uint64_t(2) << bit) - 1;
+                return 1 + counts_[size_t(i / 64)] + uint64_t(TL::popcount(bits_[size_t(i / 64)] & mask));
+            }
+
+        // Legendre's phi(x,a), the number of integers from 1 to x not
+        // divisible by any of the first a primes. This uses the identity
+        // phi(x,a) = phi(x,6) - sum[6<=i<a] phi(x/p[i],i), with phi(x,6)
+        // from a table covering one period of 2*3*5*7*11*13. The recursion
+        // stops early once x/p[i] is small enough for pi(x) to answer it, or
+        // when x and a are small enough for the cache. The cache holds one
+        // row for each a, with one bit for each odd number not yet sieved
+        // out, and a running count before each 64-bit word.
+
+        class PhiCalculator {
+        public:
+            PhiCalculator(const std::vector<uint64_t>& primes, const PrimePiTable& pi);
+            uint64_t operator()(uint64_t x, size_t a) const noexcept;
+        private:
+            static constexpr size_t small_count = 6;
+            static constexpr uint64_t small_period = 30030;
+            static constexpr uint64_t small_totient = 5760;
+            static constexpr size_t cache_rows = 64;
+            static constexpr uint64_t cache_limit = uint64_t(1) << 21;
+            static constexpr size_t cache_words = size_t(cache_limit / 128);
+            struct CacheWord {
+                uint64_t bits;
+                uint32_t count;
+            };
+            const std::vector<uint64_t>& primes_;
+            const PrimePiTable& pi_;
+            std::vector<CacheWord> cache_;
+            size_t rows_;
+            static uint64_t small_phi(uint64_t x) noexcept;
+        };
+
+            PhiCalculator::PhiCalculator(const std::vector<uint64_t>& primes, const PrimePiTable& pi):
+            primes_(primes),
+            pi_(pi),
+            cache_(),
+            rows_(std::min(primes.size(), cache_rows)) {
+                if (rows_ <= small_count + 1)
+                    return;
+                cache_.resize(rows_ * cache_words);
+                std::vector<uint64_t> bits(cache_words, ~ uint64_t(0));
+                for (size_t a = 1; a < rows_; ++a) {
+                    uint64_t p = primes[a - 1];
+                    if (p > 2)
+                        for (uint64_t k = p; k < cache_limit; k += 2 * p)
+                            bits[size_t(k / 128)] &= ~ (uint64_t(1) << (k / 2 % 64));
+                    auto row = cache_.data() + a * cache_words;
+                    uint32_t count = 0;
+                    for (size_t i = 0; i < cache_words; ++i) {
+                        row[i] = {bits[i], count};
+                        count += uint32_t(TL::popcount(bits[i]));
+                    }
+                }
+            }
+
+            uint64_t PhiCalculator::operator()(uint64_t x, size_t a) const noexcept {
+                if (x == 0)
+                    return 0;
+                if (a > small_count && a < rows_ && x < cache_limit) {
+                    uint64_t i = (x - 1) / 2; // Index of the largest odd number <= x
+                    uint64_t bit = i % 64;
+                    uint64_t mask = bit == 63 ? ~ uint64_t(0) : (uint64_t(2) << bit) - 1;
+                    auto& word = cache_[size_t(a * cache_words + i / 64)];
+                    return word.count + uint64_t(TL::popcount(word.bits & mask));
+                }
+                if (a <= small_count)
+                    return small_phi(x);
+                if (x < primes_[a])
+                    return 1;
+                if (x <= pi_.limit() && x / primes_[a] < primes_[a])
+                    return pi_(x) - a + 1;
+                uint64_t phi = small_phi(x);
+                for (size_t i = small_count; i < a; ++i) {
+                    uint64_t p = primes_[i];
+                    if (x / p < p && x <= pi_.limit()) {
+                        // Every remaining term is phi(x/p,i) = 1, for each p<=x
+                        phi -= std::min(uint64_t(a), pi_(x)) - i;
+                        break;
+                    }
+                    phi -= (*this)(x / p, i);
+                }
+                return phi;
+            }
+
+            uint64_t PhiCalculator::small_phi(uint64_t x) noexcept {
+                static const auto table = [] {
+                    std::vector<uint16_t> t(small_period);
+                    uint16_t count = 0;
+                    for (uint64_t i = 1; i < small_period; ++i) {
+                        if (i % 2 && i % 3 && i % 5 && i % 7 && i % 11 && i % 13)
+                            ++count;
+                        t[i] = count;
+                    }
+                    return t;
+                }();
+                return x / small_period * small_totient + table[size_t(x % small_period)];
+            }
+
+        // Divisibility test by an odd prime without a division: n is a
+        // multiple of p if and only if n*inv(p) mod 2^64 <= (2^64-1)/p.
+        // Covers the trial division primes used by the batch factorizer.
+
+        constexpr size_t trial_prime_count = 171; // Odd primes below 1024
+
+        struct TrialDivisor {
+            uint64_t inverse;
+            uint64_t limit;
+        };
+
+        constexpr uint64_t inverse64(uint64_t n) noexcept {
+            uint64_t x = n; // Correct to 3 bits for odd n, each step doubles that
+            for (int i = 0; i < 5; ++i)
+                x *= 2 - n * x;
+            return x;
+        }
+
+        constexpr std::array<TrialDivisor, trial_prime_count> make_trial_divisors() noexcept {
+            std::array<TrialDivisor, trial_prime_count> divisors = {};
+            for (size_t i = 0; i < trial_prime_count; ++i) {
+                uint64_t p = Detail::small_primes[i + 1];
+                divisors[i] = { inverse64(p), ~ uint64_t(0) / p };
+            }
+            return divisors;
+        }
+
+        constexpr auto trial_divisors = make_trial_divisors();
+
+        #ifdef __SIZEOF_INT128__
+
+            // Montgomery arithmetic modulo an odd 64-bit n, with R=2^64, so
+            // that the inner loops of Miller-Rabin and Pollard-Brent need no
+            // 128-bit divisions
+
+            class Montgomery64 {
+            public:
+                explicit Montgomery64(uint64_t n) noexcept:
+                    n_(n), inv_(inverse64(n)), one_((0 - n) % n),
+                    r2_(uint64_t(uint128(one_) * one_ % n)) {}
+                uint64_t one() const noexcept { return one_; }
+                uint64_t to(uint64_t x) const noexcept { return mul(x, r2_); }
+                uint64_t add(uint64_t x, uint64_t y) const noexcept { return x >= n_ - y ? x - (n_ - y) : x + y; }
+                uint64_t mul(uint64_t x, uint64_t y) const noexcept {
+                    uint128 t = uint128(x) * y;
+                    uint64_t m = uint64_t(t) * inv_;
+                    uint64_t hi = uint64_t(t >> 64);
+                    uint64_t mn = uint64_t((uint128(m) * n_) >> 64);
+                    return hi >= mn ? hi - mn : hi - mn + n_;
+                }
+            private:
+                __extension__ using uint128 = unsigned __int128;
+                uint64_t n_, inv_, one_, r2_;
+            };
+
+            // The same as Detail::is_prime64(), using Montgomery arithmetic
+
+            bool is_prime_montgomery(uint64_t n) noexcept {
+                static constexpr uint64_t bases[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+                if (n < (uint64_t(1) << 32))
+                    return Detail::is_prime32(uint32_t(n));
+                if (n % 2 == 0)
+                    return false;
+                Montgomery64 mont(n);
+                uint64_t minus_one = n - mont.one();
+                uint64_t d = n - 1;
+                int s = 0;
+                for (; (d & 1) == 0; d >>= 1)
+                    ++s;
+                for (auto a: bases) {
+                    a %= n;
+                    if (a == 0)
+                        continue;
+                    uint64_t x = mont.one();
+                    uint64_t y = mont.to(a);
+                    for (uint64_t e = d; e != 0; e >>= 1) {
+                        if (e & 1)
+                            x = mont.mul(x, y);
+                        y = mont.mul(y, y);
+                    }
+                    if (x == mont.one() || x == minus_one)
+                        continue;
+                    int r = 1;
+                    for (; r < s; ++r) {
+                        x = mont.mul(x, x);
+                        if (x == minus_one)
+                            break;
+                    }
+                    if (r == s)
+                        return false;
+                }
+                return true;
+            }
+
+            // The same as Detail::pollard_brent64(), using Montgomery
+            // arithmetic. Values are left in Montgomery form throughout:
+            // this changes the polynomial, but the differences are only
+            // scaled by a factor coprime to n, so the gcds are unaffected.
+
+            uint64_t pollard_brent_montgomery(uint64_t n, uint64_t c) noexcept {
+
+                static constexpr uint64_t batch = 128;
+
+                Montgomery64 mont(n);
+                c = mont.to(c);
+                auto f = [&mont,c] (uint64_t x) { return mont.add(mont.mul(x, x), c); };
+                uint64_t x = mont.one(), y = x, ys = x, q = x, g = 1;
+
+                for (uint64_t r = 1; g == 1; r *= 2) {
+                    x = y;
+                    for (uint64_t i = 0; i < r; ++i)
+                        y = f(y);
+                    for (uint64_t k = 0; k < r && g == 1; k += batch) {
+                        ys = y;
+                        for (uint64_t i = 0, j = std::min(batch, r - k); i < j; ++i) {
+                            y = f(y);
+                            q = mont.mul(q, x > y ? x - y : y - x);
+                        }
+                        g = std::gcd(q, n);
+                    }
+                }
+
+                if (g == n) {
+                    do {
+                        ys = f(ys);
+                        g = std::gcd(x > ys ? x - ys : ys - x, n);
+                    } while (g == 1);
+                }
+
+                return g;
+
+            }
+
+        #else
+
+            bool is_prime_montgomery(uint64_t n) noexcept { return Detail::is_prime64(n); }
+            uint64_t pollard_brent_montgomery(uint64_t n, uint64_t c) noexcept { return Detail::pollard_brent64(n, c); }
+
+        #endif
+
+        // Smallest prime factor of each odd number up to a limit, shared by
+        // all the numbers in a batch. Primes are stored as zero. Composites
+        // in range have a factor below 2^16, so it fits in 16 bits.
+
+        class SmallFactorTable {
+        public:
+            explicit SmallFactorTable(uint64_t limit);
+            uint64_t limit() const noexcept { return limit_; }
+            uint64_t smallest_factor(uint64_t n) const noexcept { auto p = factors_[size_t(n / 2)]; return p == 0 ? n : p; }
+        private:
+            std::vector<uint16_t> factors_;
+            uint64_t limit_;
+        };
+
+            SmallFactorTable::SmallFactorTable(uint64_t limit):
+            factors_(size_t(limit / 2 + 1), 0),
+            limit_(limit) {
+                for (size_t i = 1; i < Detail::small_prime_count; ++i) {
+                    uint64_t p = Detail::small_primes[i];
+                    if (p * p > limit)
+                        break;
+                    for (uint64_t n = p * p; n <= limit; n += 2 * p)
+                        if (factors_[size_t(n / 2)] == 0)
+                            factors_[size_t(n / 2)] = uint16_t(p);
+                }
+            }
+
+        // The same as Detail::factorize64(), except that cofactors small
+        // enough for the table are split by lookup, the arithmetic avoids
+        // divisions wherever possible, and pending cofactors are kept on a
+        // fixed size stack, so nothing is allocated beyond the output. A
+        // 64-bit number has at most 64 factors.
+
+        void factorize_with_table(uint64_t n, const SmallFactorTable& table, std::vector<uint64_t>& factors) {
+
+            size_t start = factors.size();
+
+            for (; n % 2 == 0; n /= 2)
+                factors.push_back(2);
+
+            for (size_t i = 0; n > table.limit() && i < trial_prime_count; ++i) {
+                uint64_t p = Detail::small_primes[i + 1];
+                if (p * p > n)
+                    break;
+                auto& div = trial_divisors[i];
+                for (uint64_t q = n * div.inverse; q <= div.limit; q = n * div.inverse) {
+                    factors.push_back(p);
+                    n = q;
+                }
+            }
+
+            uint64_t pending[64];
+            size_t top = 0;
+
+            if (n > 1)
+                pending[top++] = n;
+
+            while (top > 0) {
+                n = pending[--top];
+                if (n <= table.limit()) {
+                    while (n > 1) {
+                        uint64_t p = table.smallest_factor(n);
+                        factors.push_back(p);
+                        n /= p;
+                    }
+                } else if (is_prime_montgomery(n)) {
+                    factors.push_back(n);
+                } else {
+                    uint64_t d = n;
+                    for (uint64_t c = 1; d == n; ++c)
+                        d = pollard_brent_montgomery(n, c);
+                    pending[top++] = d;
+                    pending[top++] = n / d;
+                }
+            }
+
+            std::sort(factors.begin() + start, factors.end());
+
+        }
+
+        // Splits a range into chunks for parallel sieving. Every chunk except
+        // possibly the last is wide enough to be sieved exactly by its own
+        // PrimeSieve, and there are enough of them to keep all the threads
+        // busy if some chunks are slower than others.
+
+        using Chunk = std::pair<uint64_t, uint64_t>;
+
+        std::vector<Chunk> split_range(uint64_t m, uint64_t n, size_t threads) {
+            std::vector<Chunk> chunks;
+            m = std::max(m, uint64_t(2));
+            if (n < m)
+                return chunks;
+            uint64_t width = (n - m) / (8 * threads) + 1;
+            width = std::max({width, isqrt(n) + 1, min_sieve_limit});
+            for (uint64_t lo = m;; lo += width) {
+                uint64_t hi = n - lo < width ? n : lo + width - 1;
+                chunks.push_back({lo, hi});
+                if (hi == n)
+                    break;
+            }
+            return chunks;
+        }
+
+        // Calls f(i) for each chunk index, spreading the calls over the
+        // threads. Any exception thrown by f() is passed on to the caller.
+
+        template <typename F>
+        void for_each_chunk(size_t chunks, size_t threads, F f) {
+            threads = std::min(threads, chunks);
+            if (threads <= 1) {
+                for (size_t i = 0; i < chunks; ++i)
+                    f(i);
+                return;
+            }
+            std::atomic<size_t> next_chunk(0);
+            auto worker = [&] {
+                for (size_t i = next_chunk++; i < chunks; i = next_chunk++)
+                    f(i);
+            };
+            std::vector<std::future<void>> futures;
+            for (size_t t = 0; t < threads; ++t)
+                futures.push_back(std::async(std::launch::async, worker));
+            for (auto& fut: futures)
+                fut.get();
+        }
+
+        size_t thread_count(size_t threads) noexcept {
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            return std::max(threads, size_t(1));
+        }
+
+    }
+
+    PrimeSieve::PrimeSieve(uint64_t m, uint64_t n, size_t segment_bytes):
+    min_(std::max(m, uint64_t(2))),
+    max_(n) {
+
+        if (max_ < min_)
+            return;
+
+        base_ = min_ - min_ % 30;
+        total_bytes_ = max_ / 30 - base_ / 30 + 1;
+        segment_.resize(size_t(std::min(uint64_t(std::max(segment_bytes, size_t(1))), total_bytes_)));
+
+        // Find the sieving primes using a smaller sieve, and the first
+        // multiple of each that needs crossing off: p^2 or the first
+        // multiple at or above the base, whichever is greater, with the
+        // multiplier coprime to 30. A narrow window high in the 64-bit range
+        // would need far more sieving primes than the window has numbers in
+        // it, so the sieving primes are limited by the width of the window,
+        // and the survivors are tested individually.
+
+        uint64_t root = isqrt(max_);
+        uint64_t limit = std::max(max_ - min_, min_sieve_limit);
+
+        if (limit < root) {
+            root = limit;
+            exact_ = false;
+        }
+
+        if (root < 7)
+            return;
+
+        // Primes large enough to skip whole segments are kept in a ring of
+        // buckets, one per segment, big enough to cover the longest step
+
+        uint64_t seg_size = segment_.size();
+        uint64_t max_step = 6 * (root / 30 + 1);
+        if (root / 30 >= seg_size)
+            buckets_.resize(size_t(max_step / seg_size + 3));
+
+        PrimeSieve sub(7, root);
+        std::vector<uint64_t> primes;
+
+        while (sub.next(primes)) {
+            for (auto p: primes) {
+                uint64_t k = std::max(p, base_ / p + (base_ % p != 0));
+                while (wheel.index[k % 30] < 0)
+                    ++k;
+                if (k > max_ / p)
+                    continue;
+                Detail::SievingPrime sp;
+                sp.offset = p * k / 30 - base_ / 30;
+                sp.step = uint32_t(p / 30);
+                sp.residue = uint8_t(wheel.index[p % 30]);
+                sp.wheel = uint8_t(wheel.index[k % 30]);
+                if (sp.step < seg_size)
+                    sieving_.push_back(sp);
+                else
+                    schedule(sp, 0);
+            }
+        }
+
+    }
+
+    uint64_t PrimeSieve::count() {
+
+        uint64_t n = 0;
+
+        if (done_bytes_ == 0)
+            for (uint64_t p: { 2, 3, 5 })
+                if (p >= min_ && p <= max_)
+                    ++n;
+
+        while (done_bytes_ < total_bytes_) {
+            uint64_t block = base_ + 30 * done_bytes_;
+            auto len = sieve_segment();
+            auto seg = segment_.data();
+            if (exact_) {
+                for (uint64_t i = 0; i < len; ++i)
+                    n += wheel.bit_count[seg[i]];
+            } else {
+                for (uint64_t i = 0; i < len; ++i, block += 30)
+                    for (unsigned bits = seg[i]; bits != 0; bits &= bits - 1)
+                        n += Detail::is_prime64(block + wheel_residues[wheel.lowest_bit[bits]]);
+            }
+        }
+
+        return n;
+
+    }
+
+    bool PrimeSieve::next(std::vector<uint64_t>& primes) {
+
+        primes.clear();
+
+        if (done_bytes_ == total_bytes_)
+            return false;
+
+        if (done_bytes_ == 0)
+            for (uint64_t p: { 2, 3, 5 })
+                if (p >= min_ && p <= max_)
+                    primes.push_back(p);
+
+        uint64_t block = base_ + 30 * done_bytes_;
+        auto len = sieve_segment();
+        auto seg = segment_.data();
+
+        for (uint64_t i = 0; i < len; ++i, block += 30) {
+            for (unsigned bits = seg[i]; bits != 0; bits &= bits - 1) {
+                uint64_t p = block + wheel_residues[wheel.lowest_bit[bits]];
+                if (exact_ || Detail::is_prime64(p))
+                    primes.push_back(p);
+            }
+        }
+
+        return true;
+
+    }
+
+    // Sieves the next segment, clearing any bits outside the range, and
+    // returns its length in bytes
+
+    uint64_t PrimeSieve::sieve_segment() {
+
+        auto len = std::min(uint64_t(segment_.size()), total_bytes_ - done_bytes_);
+        auto seg = segment_.data();
+        std::fill(seg, seg + len, uint8_t(0xff));
+
+        for (auto& sp: sieving_) {
+
+            const auto& mask = wheel.mask[sp.residue];
+            const auto& carry = wheel.carry[sp.residue];
+            uint64_t offset = sp.offset;
+            unsigned w = sp.wheel;
+
+            // A full turn of the wheel advances 30p, which is always p bytes,
+            // so small primes can cross off eight multiples at a time
+
+            uint64_t p = 30 * uint64_t(sp.step) + wheel_residues[sp.residue];
+
+            if (offset + p <= len) {
+                uint64_t delta[8];
+                uint8_t keep[8];
+                uint64_t d = 0;
+                for (unsigned i = 0; i < 8; ++i) {
+                    unsigned v = (w + i) & 7;
+                    delta[i] = d;
+                    keep[i] = uint8_t(~ mask[v]);
+                    d += sp.step * wheel_gaps[v] + carry[v];
+                }
+                for (; offset + p <= len; offset += p)
+                    for (unsigned i = 0; i < 8; ++i)
+                        seg[offset + delta[i]] &= keep[i];
+            }
+
+            while (offset < len) {
+                seg[offset] &= uint8_t(~ mask[w]);
+                offset += sp.step * wheel_gaps[w] + carry[w];
+                w = (w + 1) & 7;
+            }
+            sp.offset = offset - len;
+            sp.wheel = uint8_t(w);
+        }
+
+        if (! buckets_.empty()) {
+            uint64_t current = done_bytes_ / segment_.size();
+            auto& bucket = buckets_[size_t(current % buckets_.size())];
+            for (auto sp: bucket) {
+                const auto& mask = wheel.mask[sp.residue];
+                const auto& carry = wheel.carry[sp.residue];
+                while (sp.offset < len) {
+                    seg[sp.offset] &= uint8_t(~ mask[sp.wheel]);
+                    sp.offset += sp.step * wheel_gaps[sp.wheel] + carry[sp.wheel];
+                    sp.wheel = uint8_t((sp.wheel + 1) & 7);
+                }
+                sp.offset -= len;
+                schedule(sp, current + 1);
+            }
+            bucket.clear();
+        }
+
+        // The last block start never exceeds max_, but block+residue might
+        // overflow near the top of the 64-bit range
+
+        uint64_t block = base_ + 30 * done_bytes_;
+
+        if (done_bytes_ == 0)
+            for (int j = 0; j < 8; ++j)
+                if (base_ + wheel_residues[j] < min_)
+                    seg[0] &= uint8_t(~ (1 << j));
+
+        if (done_bytes_ + len == total_bytes_) {
+            uint64_t last = block + 30 * (len - 1);
+            for (int j = 0; j < 8; ++j)
+                if (wheel_residues[j] > max_ - last)
+                    seg[len - 1] &= uint8_t(~ (1 << j));
+        }
+
+        done_bytes_ += len;
+
+        return len;
+
+    }
+
+    // Files a large sieving prime under the segment containing its next
+    // multiple. The offset is relative to the start of the given segment.
+    // A prime whose next multiple is beyond the end of the ring is filed in
+    // the last bucket, and will be refiled when that segment is reached.
+
+    void PrimeSieve::schedule(Detail::SievingPrime sp, uint64_t segment) {
+        uint64_t seg_size = segment_.size();
+        uint64_t delta = std::min(sp.offset / seg_size, uint64_t(buckets_.size() - 2));
+        sp.offset -= delta * seg_size;
+        buckets_[size_t((segment + delta) % buckets_.size())].push_back(sp);
+    }
+
+    // Each chunk is sieved independently, and the results are combined in
+    // chunk order, so the output does not depend on the number of threads
+
+    std::vector<uint64_t> parallel_prime_list(uint64_t m, uint64_t n, size_t threads) {
+
+        threads = thread_count(threads);
+        auto chunks = split_range(m, n, threads);
+        std::vector<std::vector<uint64_t>> lists(chunks.size());
+
+        for_each_chunk(chunks.size(), threads, [&] (size_t i) {
+            PrimeSieve sieve(chunks[i].first, chunks[i].second);
+            std::vector<uint64_t> primes;
+            while (sieve.next(primes))
+                lists[i].insert(lists[i].end(), primes.begin(), primes.end());
+        });
+
+        size_t total = 0;
+        for (auto& list: lists)
+            total += list.size();
+        std::vector<uint64_t> result;
+        result.reserve(total);
+        for (auto& list: lists) {
+            result.insert(result.end(), list.begin(), list.end());
+            list = {};
+        }
+
+        return result;
+
+    }
+
+    uint64_t parallel_prime_count(uint64_t m, uint64_t n, size_t threads) {
+
+        threads = thread_count(threads);
+        auto chunks = split_range(m, n, threads);
+        std::vector<uint64_t> counts(chunks.size());
+
+        for_each_chunk(chunks.size(), threads, [&] (size_t i) {
+            PrimeSieve sieve(chunks[i].first, chunks[i].second);
+            counts[i] = sieve.count();
+        });
+
+        return std::accumulate(counts.begin(), counts.end(), uint64_t(0));
+
+    }
+
+    namespace Detail {
+
+        // Meissel's formula, pi(x) = phi(x,a) + a - 1 - P2(x,a), with
+        // a = pi(cbrt(x)). P2 is the number of integers up to x that are the
+        // product of exactly two primes greater than p[a]; each term needs
+        // pi(x/p) for a prime from cbrt(x) to sqrt(x). Anything up to the
+        // limit of the pi table is looked up directly; the rest are counted by
+        // sieving upwards from there, taking the primes in descending order.
+
+        uint64_t prime_count64(uint64_t x) {
+
+            static constexpr uint64_t direct_limit = 1'000'000;
+            static constexpr uint64_t max_table_limit = uint64_t(1) << 26;
+
+            if (x < direct_limit)
+                return PrimeSieve(0, x).count();
+
+            uint64_t y = icbrt(x);
+            uint64_t r = isqrt(x);
+            uint64_t table_limit = std::max(r, std::min(y * y, max_table_limit));
+            PrimePiTable pi(table_limit);
+
+            std::vector<uint64_t> small_primes;
+            std::vector<uint32_t> large_primes;
+            std::vector<uint64_t> primes;
+            PrimeSieve sieve(0, r);
+
+            while (sieve.next(primes)) {
+                for (auto p: primes) {
+                    if (p <= y)
+                        small_primes.push_back(p);
+                    else
+                        large_primes.push_back(uint32_t(p));
+                }
+            }
+
+            // The phi calculator needs one more prime beyond a, and for
+            // x>=direct_limit there is always at least one prime between
+            // cbrt(x) and sqrt(x)
+
+            uint64_t a = small_primes.size();
+            small_primes.push_back(large_primes.front());
+            PhiCalculator phi(small_primes, pi);
+            uint64_t count = phi(x, size_t(a)) + a - 1;
+
+            uint64_t top = x / large_primes.front();
+            uint64_t before = pi(table_limit);
+            sieve = PrimeSieve(table_limit + 1, top);
+            primes.clear();
+
+            for (size_t k = large_primes.size(); k > 0; --k) {
+                uint64_t t = x / large_primes[k - 1];
+                uint64_t pi_t;
+                if (t <= table_limit) {
+                    pi_t = pi(t);
+                } else {
+                    while (primes.empty() || primes.back() < t) {
+                        before += primes.size();
+                        if (! sieve.next(primes))
+                            break;
+                    }
+                    pi_t = before + uint64_t(std::upper_bound(primes.begin(), primes.end(), t) - primes.begin());
+                }
+                count -= pi_t - a - (k - 1);
+            }
+
+            return count;
+
+        }
+
+        // The table size is limited by the largest value, and by the size of
+        // the batch, so that a small batch does not spend longer building the
+        // table than factorizing. Each chunk of values is factorized
+        // independently, and the results are combined in order.
+
+        void factor_batch64(const uint64_t* values, size_t count, size_t threads,
+                std::vector<size_t>& offsets, std::vector<uint64_t>& factors) {
+
+            static constexpr uint64_t max_table_limit = uint64_t(1) << 24;
+            static constexpr uint64_t table_per_value = 16;
+            static constexpr size_t min_chunk = 1024;
+
+            offsets.assign(1, 0);
+            factors.clear();
+
+            if (count == 0)
+                return;
+
+            uint64_t max_value = *std::max_element(values, values + count);
+            uint64_t table_limit = std::min({max_value, max_table_limit, uint64_t(count) * table_per_value});
+            SmallFactorTable table(table_limit);
+
+            threads = thread_count(threads);
+            size_t chunk = std::max(count / (8 * threads) + 1, min_chunk);
+            size_t n_chunks = (count - 1) / chunk + 1;
+            std::vector<std::vector<uint64_t>> chunk_factors(n_chunks);
+            std::vector<size_t> sizes(count);
+
+            for_each_chunk(n_chunks, threads, [&] (size_t i) {
+                size_t begin = i * chunk;
+                size_t end = std::min(begin + chunk, count);
+                auto& out = chunk_factors[i];
+                for (size_t j = begin; j < end; ++j) {
+                    size_t before = out.size();
+                    if (values[j] >= 2)
+                        factorize_with_table(values[j], table, out);
+                    sizes[j] = out.size() - before;
+                }
+            });
+
+            offsets.resize(count + 1);
+            for (size_t i = 0; i < count; ++i)
+                offsets[i + 1] = offsets[i] + sizes[i];
+            factors.reserve(offsets[count]);
+            for (auto& out: chunk_factors) {
+                factors.insert(factors.end(), out.begin(), out.end());
+                out = {};
+            }
+
+        }
+
+    }
+
+}
@@ -2,89 +2,149 @@
 
 #include "rs-tl/iterator.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <map>
-#include <memory>
-#include <unordered_map>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace RS::Sci {
 
+    namespace Detail {
+
+        // Conversion from a 64-bit value, allowing for types such as MPZ
+        // that can only be constructed from a signed 64-bit integer
+
+        template <typename T>
+        T from_uint64(uint64_t n) {
+            if constexpr (std::is_integral_v<T>)
+                return T(n);
+            else if (n <= uint64_t(INT64_MAX))
+                return T(n);
+            else
+                return T(n >> 1) * T(2) + T(n & 1);
+        }
+
+        // True if a non-negative value fits in 64 bits
+
+        template <typename T>
+        constexpr bool fits_in_64_bits(const T& n) {
+            if constexpr (std::is_integral_v<T> && sizeof(T) <= 8)
+                return true;
+            else
+                return n <= from_uint64<T>(~ uint64_t(0));
+        }
+
+        // The primes below 2^16, generated at compile time
+
+        constexpr uint32_t small_prime_limit = 65536;
+        constexpr size_t small_prime_count = 6542;
+
+        constexpr std::array<uint16_t, small_prime_count> make_small_primes() noexcept {
+            std::array<uint16_t, small_prime_count> primes = {};
+            bool composite[small_prime_limit / 2] = {}; // Odd numbers only
+            size_t count = 0;
+            primes[count++] = 2;
+            for (uint32_t i = 1; i < small_prime_limit / 2; ++i) {
+                if (! composite[i]) {
+                    uint32_t p = 2 * i + 1;
+                    primes[count++] = uint16_t(p);
+                    for (uint64_t j = uint64_t(p) * p / 2; j < small_prime_limit / 2; j += p)
+                        composite[j] = true;
+                }
+            }
+            return primes;
+        }
+
+        inline constexpr auto small_primes = make_small_primes();
+
+        struct SievingPrime {
+            uint64_t offset;  // Next multiple to cross off, as a byte offset into the current segment
+            uint32_t step;    // p/30
+            uint8_t residue;  // Wheel index of p mod 30
+            uint8_t wheel;    // Wheel index of the next multiplier mod 30
+        };
+
+    }
+
+    class PrimeSieve {
+    public:
+        static constexpr size_t default_segment_bytes = 32768;
+        PrimeSieve() = default;
+        PrimeSieve(uint64_t m, uint64_t n, size_t segment_bytes = default_segment_bytes);
+        uint64_t count();
+        bool next(std::vector<uint64_t>& primes);
+    private:
+        std::vector<Detail::SievingPrime> sieving_; // Primes that hit every segment
+        std::vector<std::vector<Detail::SievingPrime>> buckets_; // Larger primes, by the segment they hit next
+        std::vector<uint8_t> segment_;
+        uint64_t min_ = 0;
+        uint64_t max_ = 0;
+        uint64_t base_ = 0; // min_ rounded down to a multiple of 30
+        uint64_t total_bytes_ = 0;
+        uint64_t done_bytes_ = 0;
+        bool exact_ = true; // False if sieving stops short of sqrt(max)
+        void schedule(Detail::SievingPrime sp, uint64_t segment);
+        uint64_t sieve_segment();
+    };
+
+    std::vector<uint64_t> parallel_prime_list(uint64_t m, uint64_t n, size_t threads = 0);
+    uint64_t parallel_prime_count(uint64_t m, uint64_t n, size_t threads = 0);
+
+    template <typename T> constexpr bool is_prime(T n);
+
+    // Primes below 2^16 come from the compile time table, so a short run
+    // allocates nothing. Primes below 2^64 come from a series of sieve
+    // windows, each twice as wide as the last, so the sieving primes never
+    // need to go beyond the square root of the current prime. Anything beyond
+    // that is found by testing odd numbers individually.
+
     template <typename T>
     class PrimeGenerator {
     public:
-        PrimeGenerator(const PrimeGenerator& pg);
-        PrimeGenerator& operator=(const PrimeGenerator& pg);
-        PrimeGenerator() = default;
-        PrimeGenerator(PrimeGenerator&& pg) = default;
-        PrimeGenerator& operator=(PrimeGenerator&& pg) = default;
+        static constexpr size_t segment_bytes = 4096;
         T operator()() { next(); return get(); }
         const T& get() const noexcept { return current_; }
         void next();
     private:
-        std::unordered_map<T, T> multiples_;
-        std::unique_ptr<PrimeGenerator> recurse_;
+        PrimeSieve sieve_;
+        std::vector<uint64_t> buffer_;
+        size_t index_ = 0; // Index into the small prime table, then the buffer
+        uint64_t limit_ = 0; // Upper end of the current window, or zero while using the table
         T current_ = 1;
-        T factor_ = 0;
-        T square_ = 0;
     };
 
-        template <typename T>
-        PrimeGenerator<T>::PrimeGenerator(const PrimeGenerator& pg):
-        multiples_(pg.multiples_),
-        recurse_(),
-        current_(pg.current_),
-        factor_(pg.factor_),
-        square_(pg.square_) {
-            if (pg.recurse_)
-                recurse_ = std::make_unique<PrimeGenerator>(*pg.recurse_);
-        }
-
-        template <typename T>
-        PrimeGenerator<T>& PrimeGenerator<T>::operator=(const PrimeGenerator& pg) {
-            auto copy(pg);
-            std::swap(copy, *this);
-            return *this;
-        }
-
         template <typename T>
         void PrimeGenerator<T>::next() {
-            if (current_ < 3) {
-                ++current_;
-                return;
-            }
-            if (current_ < 7) {
-                current_ += 2;
-                return;
-            }
-            if (! recurse_) {
-                multiples_.clear();
-                recurse_ = std::make_unique<PrimeGenerator>();
-                recurse_->next();
-                recurse_->next();
-                factor_ = recurse_->get();
-                square_ = factor_ * factor_;
+            static constexpr uint64_t max64 = ~ uint64_t(0);
+            static constexpr uint64_t min_window = 65536;
+            if (limit_ == 0) {
+                if (index_ < Detail::small_prime_count) {
+                    current_ = T(Detail::small_primes[index_++]);
+                    return;
+                }
+                index_ = 0;
+                limit_ = Detail::small_prime_limit - 1;
             }
             for (;;) {
-                current_ += 2;
-                if (current_ == square_) {
-                    T delta = 2 * factor_;
-                    T next = square_ + delta;
-                    multiples_.insert({next, delta});
-                    recurse_->next();
-                    factor_ = recurse_->get();
-                    square_ = factor_ * factor_;
-                } else {
-                    auto it = multiples_.find(current_);
-                    if (it == multiples_.end())
-                        return;
-                    T delta = it->second;
-                    T next = it->first + delta;
-                    while (multiples_.count(next))
-                        next += delta;
-                    multiples_.erase(it);
-                    multiples_.insert({next, delta});
+                if (index_ < buffer_.size()) {
+                    current_ = Detail::from_uint64<T>(buffer_[index_++]);
+                    return;
                 }
+                index_ = 0;
+                if (sieve_.next(buffer_))
+                    continue;
+                if (limit_ == max64)
+                    break;
+                uint64_t lo = limit_ + 1;
+                uint64_t width = std::max(lo, min_window);
+                limit_ = max64 - lo < width ? max64 : lo + width - 1;
+                sieve_ = PrimeSieve(lo, limit_, segment_bytes);
             }
+            do current_ += 2;
+                while (! is_prime(current_));
         }
 
     template <typename T>
@@ -106,12 +166,205 @@ namespace RS::Sci {
         return TL::irange(PI(true), PI(false));
     }
 
+    namespace Detail {
+
+        constexpr uint64_t mulmod64(uint64_t a, uint64_t b, uint64_t m) noexcept {
+            #ifdef __SIZEOF_INT128__
+                __extension__ using uint128 = unsigned __int128;
+                return uint64_t(uint128(a) * b % m);
+            #else
+                uint64_t z = 0;
+                a %= m;
+                for (; b != 0; b >>= 1) {
+                    if (b & 1)
+                        z = z >= m - a ? z - (m - a) : z + a;
+                    a = a >= m - a ? a - (m - a) : a + a;
+                }
+                return z;
+            #endif
+        }
+
+        constexpr uint64_t powmod64(uint64_t a, uint64_t n, uint64_t m) noexcept {
+            uint64_t z = 1;
+            for (; n != 0; n >>= 1) {
+                if (n & 1)
+                    z = mulmod64(z, a, m);
+                a = mulmod64(a, a, m);
+            }
+            return z;
+        }
+
+        // Strong probable prime test to base a, for odd n>a
+
+        constexpr bool is_strong_probable_prime64(uint64_t n, uint64_t a) noexcept {
+            uint64_t d = n - 1;
+            int s = 0;
+            for (; (d & 1) == 0; d >>= 1)
+                ++s;
+            uint64_t x = powmod64(a, d, n);
+            if (x == 1 || x == n - 1)
+                return true;
+            for (int r = 1; r < s; ++r) {
+                x = mulmod64(x, x, n);
+                if (x == n - 1)
+                    return true;
+            }
+            return false;
+        }
+
+        // Deterministic Miller-Rabin test for 32-bit integers, using the
+        // bases 2, 7 and 61, which are sufficient for n<4,759,123,141. This
+        // only needs 64-bit arithmetic.
+
+        constexpr bool is_prime32(uint32_t n) noexcept {
+            constexpr uint64_t bases[] = { 2, 7, 61 };
+            if (n < 2)
+                return false;
+            for (size_t i = 0; i < 12; ++i)
+                if (n % small_primes[i] == 0)
+                    return n == small_primes[i];
+            if (n < 41 * 41)
+                return true;
+            uint32_t d = n - 1;
+            int s = 0;
+            for (; (d & 1) == 0; d >>= 1)
+                ++s;
+            for (auto a: bases) {
+                uint64_t x = 1;
+                for (uint32_t e = d; e != 0; e >>= 1) {
+                    if (e & 1)
+                        x = x * a % n;
+                    a = a * a % n;
+                }
+                int r = 0;
+                if (x != 1)
+                    for (; r < s && x != n - 1; ++r)
+                        x = x * x % n;
+                if (r == s)
+                    return false;
+            }
+            return true;
+        }
+
+        // Deterministic Miller-Rabin test, using the seven bases found by
+        // Jim Sinclair that are sufficient for all 64-bit integers
+
+        constexpr bool is_prime64(uint64_t n) noexcept {
+            constexpr uint64_t bases[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+            if (n < (uint64_t(1) << 32))
+                return is_prime32(uint32_t(n));
+            for (size_t i = 0; i < 12; ++i)
+                if (n % small_primes[i] == 0)
+                    return false;
+            for (auto a: bases) {
+                a %= n;
+                if (a != 0 && ! is_strong_probable_prime64(n, a))
+                    return false;
+            }
+            return true;
+        }
+
+        // Brent's variant of Pollard's rho algorithm, for odd composite n,
+        // iterating x -> x^2+c. Differences are accumulated in batches so
+        // that only one gcd is needed per batch. Returns n on failure.
+
+        inline uint64_t pollard_brent64(uint64_t n, uint64_t c) noexcept {
+
+            static constexpr uint64_t batch = 128;
+
+            auto f = [c,n] (uint64_t x) {
+                x = mulmod64(x, x, n);
+                return x >= n - c ? x - (n - c) : x + c;
+            };
+
+            uint64_t x = 2, y = 2, ys = 2, q = 1, g = 1;
+
+            for (uint64_t r = 1; g == 1; r *= 2) {
+                x = y;
+                for (uint64_t i = 0; i < r; ++i)
+                    y = f(y);
+                for (uint64_t k = 0; k < r && g == 1; k += batch) {
+                    ys = y;
+                    for (uint64_t i = 0, j = std::min(batch, r - k); i < j; ++i) {
+                        y = f(y);
+                        q = mulmod64(q, x > y ? x - y : y - x, n);
+                    }
+                    g = std::gcd(q, n);
+                }
+            }
+
+            // If the batch overshot, step through it again one at a time
+
+            if (g == n) {
+                do {
+                    ys = f(ys);
+                    g = std::gcd(x > ys ? x - ys : ys - x, n);
+                } while (g == 1);
+            }
+
+            return g;
+
+        }
+
+        // Prime factorization of n>0, appending the factors in ascending
+        // order: trial division by small primes, then Pollard-Brent to
+        // split whatever is left, stopping whenever a cofactor tests prime
+
+        inline void factorize64(uint64_t n, std::vector<uint64_t>& factors) {
+
+            static constexpr uint64_t trial_limit = 1024;
+
+            size_t start = factors.size();
+
+            for (size_t i = 0; i < small_prime_count; ++i) {
+                uint64_t p = small_primes[i];
+                if (p >= trial_limit || p * p > n)
+                    break;
+                for (; n % p == 0; n /= p)
+                    factors.push_back(p);
+            }
+
+            std::vector<uint64_t> pending;
+            if (n > 1)
+                pending.push_back(n);
+
+            while (! pending.empty()) {
+                n = pending.back();
+                pending.pop_back();
+                if (n < trial_limit * trial_limit || is_prime64(n)) {
+                    factors.push_back(n);
+                } else {
+                    uint64_t d = n;
+                    for (uint64_t c = 1; d == n; ++c)
+                        d = pollard_brent64(n, c);
+                    pending.push_back(d);
+                    pending.push_back(n / d);
+                }
+            }
+
+            std::sort(factors.begin() + start, factors.end());
+
+        }
+
+    }
+
+    // Integer types up to 64 bits, and other types whose value fits in 64
+    // bits, use deterministic Miller-Rabin (with cheaper 64-bit arithmetic
+    // for values below 2^32), which can be evaluated at compile time for
+    // primitive types. MPN and MPZ have their own overloads (found by
+    // argument dependent lookup) using BPSW. Otherwise this falls back on
+    // trial division.
+
     template <typename T>
-    bool is_prime(T n) {
+    constexpr bool is_prime(T n) {
         if (n < 2)
             return false;
-        for (PrimeIterator<T> it; *it * *it <= n; ++it)
-            if (n % *it == 0)
+        if (Detail::fits_in_64_bits(n))
+            return Detail::is_prime64(static_cast<uint64_t>(n));
+        if (n % 2 == 0 || n % 3 == 0)
+            return false;
+        for (T p = 5; p * p <= n; p += 6)
+            if (n % p == 0 || n % (p + 2) == 0)
                 return false;
         return true;
     }
@@ -140,65 +393,144 @@ namespace RS::Sci {
         return n;
     }
 
+    // Values that fit in 64 bits use trial division and Pollard-Brent.
+    // MPN and MPZ have their own overloads, found by argument dependent
+    // lookup, that work the same way on larger values. Other types fall
+    // back on trial division.
+
     template <typename T>
     std::vector<T> prime_factors(T n) {
         std::vector<T> factors;
-        PrimeIterator<T> it;
-        while (n > 1 && *it * *it <= n) {
-            if (n % *it == 0) {
-                n /= *it;
-                factors.push_back(*it);
-            } else {
-                ++it;
+        if (n < 2)
+            return factors;
+        if (Detail::fits_in_64_bits(n)) {
+            std::vector<uint64_t> factors64;
+            Detail::factorize64(static_cast<uint64_t>(n), factors64);
+            for (auto p: factors64)
+                factors.push_back(Detail::from_uint64<T>(p));
+        } else {
+            PrimeIterator<T> it;
+            while (n > 1 && *it * *it <= n) {
+                if (n % *it == 0) {
+                    n /= *it;
+                    factors.push_back(*it);
+                } else {
+                    ++it;
+                }
             }
+            if (n > 1)
+                factors.push_back(n);
         }
-        if (n > 1)
-            factors.push_back(n);
         return factors;
     }
 
     template <typename T>
     std::map<T, T> prime_factors_map(T n) {
         std::map<T, T> factors;
-        PrimeIterator<T> it;
-        while (n > 1 && *it * *it <= n) {
-            if (n % *it == 0) {
-                n /= *it;
-                ++factors[*it];
-            } else {
-                ++it;
-            }
-        }
-        if (n > 1)
-            ++factors[n];
+        for (auto& p: prime_factors(n))
+            ++factors[p];
         return factors;
     }
 
+    template <typename T>
+    struct FactorBatch {
+        std::vector<size_t> offsets; // Factors of value i are factors[offsets[i]] to factors[offsets[i+1]-1]
+        std::vector<T> factors;
+    };
+
+    namespace Detail {
+
+        void factor_batch64(const uint64_t* values, size_t count, size_t threads,
+            std::vector<size_t>& offsets, std::vector<uint64_t>& factors);
+
+    }
+
+    template <typename T>
+    FactorBatch<T> factor_batch(const T* values, size_t count, size_t threads = 0) {
+        static_assert(std::is_integral_v<T> && sizeof(T) <= 8, "Batch factorization requires a primitive integer type");
+        FactorBatch<T> batch;
+        if constexpr (std::is_same_v<T, uint64_t>) {
+            Detail::factor_batch64(values, count, threads, batch.offsets, batch.factors);
+        } else {
+            std::vector<uint64_t> values64(count), factors64;
+            for (size_t i = 0; i < count; ++i)
+                values64[i] = values[i] < 2 ? 0 : static_cast<uint64_t>(values[i]);
+            Detail::factor_batch64(values64.data(), count, threads, batch.offsets, factors64);
+            batch.factors.assign(factors64.begin(), factors64.end());
+        }
+        return batch;
+    }
+
+    template <typename T>
+    FactorBatch<T> factor_batch(const std::vector<T>& values, size_t threads = 0) {
+        return factor_batch(values.data(), values.size(), threads);
+    }
+
+    // Ranges below 2^16 are copied from the small prime table, and other
+    // ranges that fit in 64 bits use the segmented sieve. Beyond that, each
+    // block of the range is sieved by small primes, and the survivors are
+    // tested individually.
+
     template <typename T>
     std::vector<T> prime_list(T m, T n) {
+
         std::vector<T> v;
-        if (n < 2) {
-            // do nothing
-        } else if (m <= 2) {
-            auto z = size_t(n);
-            std::vector<bool> sieve(z + 1, true);
-            sieve[0] = sieve[1] = false;
-            sieve[2] = true;
-            for (size_t i = 4; i <= z; i += 2)
-                sieve[i] = false;
-            for (size_t i = 3; 2 * i <= z; i += 2)
-                if (sieve[i])
-                    for (size_t j = 2 * i; j <= z; j += i)
-                        sieve[j] = false;
-            for (size_t i = 0; i <= z; ++i)
-                if (sieve[i])
-                    v.push_back(T(i));
+
+        if (m < 2)
+            m = 2;
+        if (n < m)
+            return v;
+
+        if (Detail::fits_in_64_bits(n) && static_cast<uint64_t>(n) < Detail::small_prime_limit) {
+
+            auto& table = Detail::small_primes;
+            auto i = std::lower_bound(table.begin(), table.end(), static_cast<uint64_t>(m));
+            auto j = std::upper_bound(i, table.end(), static_cast<uint64_t>(n));
+            for (; i != j; ++i)
+                v.push_back(T(*i));
+
+        } else if (Detail::fits_in_64_bits(n)) {
+
+            PrimeSieve sieve(static_cast<uint64_t>(m), static_cast<uint64_t>(n));
+            std::vector<uint64_t> primes;
+            while (sieve.next(primes))
+                for (auto p: primes)
+                    v.push_back(Detail::from_uint64<T>(p));
+
         } else {
-            for (T t = m; t <= n; ++t)
-                if (is_prime(t))
-                    v.push_back(t);
+
+            static constexpr uint64_t block_size = 65536;
+            static const auto small_primes = prime_list(uint64_t(2), block_size);
+
+            std::vector<uint8_t> composite;
+
+            for (T lo = m;; lo += T(block_size)) {
+                T hi = n - lo < T(block_size) ? n : lo + T(block_size - 1);
+                auto len = static_cast<uint64_t>(hi - lo) + 1;
+                composite.assign(len, 0);
+                for (auto p: small_primes) {
+                    auto r = static_cast<uint64_t>(lo % T(p));
+                    uint64_t i = r == 0 ? 0 : p - r;
+                    if (i < len && lo + T(i) == T(p))
+                        i += p;
+                    for (; i < len; i += p)
+                        composite[i] = 1;
+                }
+                for (uint64_t i = 0; i < len; ++i) {
+                    if (! composite[i]) {
+                        T t = lo + T(i);
+                        if (is_prime(t))
+                            v.push_back(t);
+                    }
+                }
+                if (hi == n)
+                    break;
+            }
+
         }
+
         return v;
+
     }
 
     template <typename T>
@@ -206,4 +538,19 @@ namespace RS::Sci {
         return prime_list(T(2), n);
     }
 
+    namespace Detail {
+
+        uint64_t prime_count64(uint64_t x);
+
+    }
+
+    template <typename T>
+    T prime_count(T x) {
+        if (x < 2)
+            return 0;
+        if (! Detail::fits_in_64_bits(x))
+            throw std::out_of_range("Prime count argument is too large");
+        return Detail::from_uint64<T>(Detail::prime_count64(static_cast<uint64_t>(x)));
+    }
+
 }
@@ -5,10 +5,13 @@
 
 #include "rs-sci/constants.hpp"
 #include "rs-tl/enum.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdlib>
 #include <limits>
 #include <type_traits>
+#include <utility>
 
 namespace RS::Sci {
 
@@ -17,6 +20,22 @@ namespace RS::Sci {
         common    // Use base 10 logs
     )
 
+    namespace Detail {
+
+        // The generate() functions work in chunks of this many values, to
+        // keep their working buffers on the stack
+
+        constexpr size_t generate_chunk = 256;
+
+        template <typename RNG, typename = void>
+        struct HasFill: std::false_type {};
+
+        template <typename RNG>
+        struct HasFill<RNG, std::void_t<decltype(std::declval<RNG&>().fill(
+            std::declval<typename RNG::result_type*>(), size_t()))>>: std::true_type {};
+
+    }
+
     template <typename T>
     class UniformReal {
 
@@ -35,6 +54,31 @@ namespace RS::Sci {
             return min_ + ((max_ - min_) / (T(rng.max()) + 1)) * rng();
         }
 
+        // With a bulk engine the output is drawn a chunk at a time, and the
+        // conversion loop is simple enough for the compiler to vectorize.
+        // A scalar engine gains nothing from this, so it just runs the same
+        // loop as repeated calls.
+
+        template <typename RNG>
+        void generate(RNG& rng, T* out, size_t n) const noexcept {
+            if constexpr (Detail::HasFill<RNG>::value) {
+                T base = min_;
+                T scale = (max_ - min_) / (T(rng.max()) + 1);
+                typename RNG::result_type raw[Detail::generate_chunk];
+                while (n > 0) {
+                    size_t m = std::min(n, Detail::generate_chunk);
+                    rng.fill(raw, m);
+                    for (size_t i = 0; i < m; ++i)
+                        out[i] = base + scale * raw[i];
+                    out += m;
+                    n -= m;
+                }
+            } else {
+                for (size_t i = 0; i < n; ++i)
+                    out[i] = (*this)(rng);
+            }
+        }
+
         constexpr T min() const noexcept { return min_; }
         constexpr T max() const noexcept { return max_; }
         constexpr T mean() const noexcept { return (min_ + max_) / 2; }
@@ -97,6 +141,30 @@ namespace RS::Sci {
             return a * b * sd_ + mean_;
         }
 
+        // Both outputs of each Box-Muller transform are used, so there is
+        // one log, one square root, and one sine/cosine pair for every two
+        // values. The first value of each pair is the same as the function
+        // call operator would return.
+
+        template <typename RNG>
+        void generate(RNG& rng, T* out, size_t n) const noexcept {
+            T uv[Detail::generate_chunk];
+            while (n > 0) {
+                size_t m = std::min(n, Detail::generate_chunk);
+                size_t pairs = (m + 1) / 2;
+                unit_.generate(rng, uv, 2 * pairs);
+                for (size_t i = 0; i < pairs; ++i) {
+                    T a = std::sqrt(-2 * std::log(1 - uv[2 * i]));
+                    T theta = 2 * pi_c<T> * uv[2 * i + 1];
+                    out[2 * i] = a * std::cos(theta) * sd_ + mean_;
+                    if (2 * i + 1 < m)
+                        out[2 * i + 1] = a * std::sin(theta) * sd_ + mean_;
+                }
+                out += m;
+                n -= m;
+            }
+        }
+
         constexpr T mean() const noexcept { return mean_; }
         constexpr T sd() const noexcept { return sd_; }
         constexpr T variance() const noexcept { return sd_ * sd_; }
@@ -160,6 +228,13 @@ namespace RS::Sci {
             return std::exp(norm_(rng));
         }
 
+        template <typename RNG>
+        void generate(RNG& rng, T* out, size_t n) const noexcept {
+            norm_.generate(rng, out, n);
+            for (size_t i = 0; i < n; ++i)
+                out[i] = std::exp(out[i]);
+        }
+
         T m() const noexcept { return norm_.mean(); }
         T s() const noexcept { return norm_.sd(); }
         T median() const noexcept { return std::exp(m()); }
@@ -188,6 +263,13 @@ namespace RS::Sci {
             return std::exp(base_(rng));
         }
 
+        template <typename RNG>
+        void generate(RNG& rng, T* out, size_t n) const noexcept {
+            base_.generate(rng, out, n);
+            for (size_t i = 0; i < n; ++i)
+                out[i] = std::exp(out[i]);
+        }
+
         constexpr T min() const noexcept { return std::exp(base_.min()); }
         constexpr T max() const noexcept { return std::exp(base_.max()); }
 
@@ -5,7 +5,9 @@
 
 #include "rs-sci/random-continuous-distributions.hpp"
 #include "rs-sci/rational.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <limits>
 #include <type_traits>
 
@@ -26,7 +28,13 @@ namespace RS::Sci {
 
         template <typename RNG>
         constexpr T operator()(RNG& rng) const noexcept {
-            return generate(rng, min(), max());
+            return generate_value(rng, min(), max());
+        }
+
+        template <typename RNG>
+        void generate(RNG& rng, T* out, size_t n) const noexcept {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = (*this)(rng);
         }
 
         constexpr T min() const noexcept { return min_; }
@@ -66,7 +74,7 @@ namespace RS::Sci {
         T max_ = 1;
 
         template <typename RNG>
-        constexpr static T generate(RNG& rng, T min, T max) noexcept {
+        constexpr static T generate_value(RNG& rng, T min, T max) noexcept {
 
             // We need an unsigned integer type big enough for both the RNG
             // and the output range.
@@ -116,7 +124,7 @@ namespace RS::Sci {
                 working_type high = 0, low = 0;
                 T ratio = T((out_range - rng_range) / (rng_range + 1));
                 do {
-                    high = generate(rng, working_type(0), ratio) * (rng_range + 1);
+                    high = generate_value(rng, working_type(0), ratio) * (rng_range + 1);
                     low = working_type(rng() - rng_min);
                 } while (low > out_range - high);
                 result = high + low;
@@ -141,6 +149,19 @@ namespace RS::Sci {
 
         template <typename RNG> constexpr bool operator()(RNG& rng) const noexcept { return UniformReal<double>()(rng) < prob_; }
 
+        template <typename RNG>
+        void generate(RNG& rng, bool* out, size_t n) const noexcept {
+            double u[Detail::generate_chunk];
+            while (n > 0) {
+                size_t m = std::min(n, Detail::generate_chunk);
+                UniformReal<double>().generate(rng, u, m);
+                for (size_t i = 0; i < m; ++i)
+                    out[i] = u[i] < prob_;
+                out += m;
+                n -= m;
+            }
+        }
+
         constexpr double p() const noexcept { return prob_; }
 
     private:
@@ -166,6 +187,19 @@ namespace RS::Sci {
             return T(std::lround(norm_(rng)));
         }
 
+        template <typename RNG>
+        void generate(RNG& rng, T* out, size_t n) const noexcept {
+            double x[Detail::generate_chunk];
+            while (n > 0) {
+                size_t m = std::min(n, Detail::generate_chunk);
+                norm_.generate(rng, x, m);
+                for (size_t i = 0; i < m; ++i)
+                    out[i] = T(std::lround(x[i]));
+                out += m;
+                n -= m;
+            }
+        }
+
         double mean() const noexcept { return norm_.mean(); }
         double sd() const noexcept { return norm_.sd(); }
 
@@ -189,50 +223,97 @@ namespace RS::Sci {
 
         template <typename RNG>
         T operator()(RNG& rng) const noexcept {
+            return draw(rng, constants());
+        }
+
+        // The constants that depend only on lambda are calculated once for
+        // all the values
+
+        template <typename RNG>
+        void generate(RNG& rng, T* out, size_t n) const noexcept {
+            auto pc = constants();
+            for (size_t i = 0; i < n; ++i)
+                out[i] = draw(rng, pc);
+        }
+
+        constexpr double mean() const noexcept { return lambda_; }
+        constexpr double variance() const noexcept { return lambda_; }
+        double sd() const noexcept { return std::sqrt(lambda_); }
+        double pdf(T x) const noexcept { return std::exp(x * log_lambda_ - lambda_ - std::lgamma(1.0 + x)); }
+        double cdf(T x) const noexcept { return x <= lambda_ + 5 ? make_cdf(x) : 1 - make_ccdf(x + 1); }
+        double ccdf(T x) const noexcept { return x <= lambda_ + 5 ? 1 - make_cdf(x - 1) : make_ccdf(x); }
+
+    private:
+
+        // https://www.johndcook.com/blog/2010/06/14/generating-poisson-random-values/
 
-            // https://www.johndcook.com/blog/2010/06/14/generating-poisson-random-values/
+        static constexpr double knuth_limit = 30;
+
+        // xl is used by the Knuth algorithm, the others by the Atkinson
+        // algorithm
+
+        struct Constants {
+            double xl = 0;
+            double alpha = 0;
+            double beta = 0;
+            double k = 0;
+        };
+
+        double lambda_ = 1;
+        double log_lambda_ = 0;
+
+        Constants constants() const noexcept {
+            Constants pc;
+            if (lambda_ <= knuth_limit) {
+                pc.xl = std::exp(- lambda_);
+            } else {
+                double c = 0.767 - 3.36 / lambda_;
+                pc.beta = pi_d / std::sqrt(3 * lambda_);
+                pc.alpha = pc.beta * lambda_;
+                pc.k = std::log(c) - lambda_ - std::log(pc.beta);
+            }
+            return pc;
+        }
+
+        template <typename RNG>
+        T draw(RNG& rng, const Constants& pc) const noexcept {
 
             T n = 0;
             UniformReal<double> unit;
 
-            if (lambda_ <= 30) {
+            if (lambda_ <= knuth_limit) {
 
                 // Knuth algorithm
 
-                double xl = std::exp(- lambda_);
-                T k = 0;
+                T j = 0;
                 double p = 1;
 
                 do {
-                    ++k;
+                    ++j;
                     double u = unit(rng);
                     p *= u;
-                } while (p > xl);
+                } while (p > pc.xl);
 
-                n = k - 1;
+                n = j - 1;
 
             } else {
 
                 // Atkinson algorithm
 
-                double c = 0.767 - 3.36 / lambda_;
-                double beta = pi_d / std::sqrt(3 * lambda_);
-                double alpha = beta * lambda_;
-                double k = std::log(c) - lambda_ - std::log(beta);
                 double a = 1;
                 double b = 0;
 
                 while (a > b) {
                     double u = unit(rng);
-                    double x = (alpha - std::log((1 - u) / u)) / beta;
+                    double x = (pc.alpha - std::log((1 - u) / u)) / pc.beta;
                     n = T(std::floor(x + 0.5));
                     if (n < 0)
                         continue;
                     double v = unit(rng);
-                    double y = alpha - beta * x;
+                    double y = pc.alpha - pc.beta * x;
                     double z = 1 + std::exp(y);
                     a = y + std::log(v / (z * z));
-                    b = k + n * log_lambda_ - std::lgamma(1.0 + n);
+                    b = pc.k + n * log_lambda_ - std::lgamma(1.0 + n);
                 }
 
             }
@@ -241,18 +322,6 @@ namespace RS::Sci {
 
         }
 
-        constexpr double mean() const noexcept { return lambda_; }
-        constexpr double variance() const noexcept { return lambda_; }
-        double sd() const noexcept { return std::sqrt(lambda_); }
-        double pdf(T x) const noexcept { return std::exp(x * log_lambda_ - lambda_ - std::lgamma(1.0 + x)); }
-        double cdf(T x) const noexcept { return x <= lambda_ + 5 ? make_cdf(x) : 1 - make_ccdf(x + 1); }
-        double ccdf(T x) const noexcept { return x <= lambda_ + 5 ? 1 - make_cdf(x - 1) : make_ccdf(x); }
-
-    private:
-
-        double lambda_ = 1;
-        double log_lambda_ = 0;
-
         double make_cdf(T x) const noexcept {
             if (x < 0)
                 return 0;
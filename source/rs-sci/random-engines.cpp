@@ -0,0 +1,197 @@
+#include "rs-sci/random-engines.hpp"
+#include <algorithm>
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define RS_SCI_RANDOM_X86 1
+    #include <immintrin.h>
+#endif
+
+namespace RS::Sci {
+
+    namespace {
+
+        constexpr size_t x8_lanes = XoshiroX8::lanes;
+
+        // Set by Detail::set_random_extensions()
+
+        std::atomic<unsigned> allowed_extensions{Detail::random_use_all};
+
+        // The same step as Xoshiro::operator(), on each lane in turn. The
+        // state is copied to local arrays so the compiler can see that the
+        // output does not alias it.
+
+        void xoshiro_x8_scalar(uint64_t (&s)[4][x8_lanes], uint64_t* out, size_t blocks) noexcept {
+            uint64_t s0[x8_lanes], s1[x8_lanes], s2[x8_lanes], s3[x8_lanes];
+            std::copy_n(s[0], x8_lanes, s0);
+            std::copy_n(s[1], x8_lanes, s1);
+            std::copy_n(s[2], x8_lanes, s2);
+            std::copy_n(s[3], x8_lanes, s3);
+            for (size_t b = 0; b < blocks; ++b, out += x8_lanes) {
+                for (size_t j = 0; j < x8_lanes; ++j) {
+                    out[j] = TL::rotl(s1[j] * 5, 7) * 9;
+                    uint64_t y = s1[j] << 17;
+                    s2[j] ^= s0[j];
+                    s3[j] ^= s1[j];
+                    s1[j] ^= s2[j];
+                    s0[j] ^= s3[j];
+                    s2[j] ^= y;
+                    s3[j] = TL::rotl(s3[j], 45);
+                }
+            }
+            std::copy_n(s0, x8_lanes, s[0]);
+            std::copy_n(s1, x8_lanes, s[1]);
+            std::copy_n(s2, x8_lanes, s[2]);
+            std::copy_n(s3, x8_lanes, s[3]);
+        }
+
+        #ifdef RS_SCI_RANDOM_X86
+
+            #define RS_SCI_AVX2_TARGET __attribute__((target("avx2")))
+            #define RS_SCI_AVX512_TARGET __attribute__((target("avx512f")))
+
+            bool has_avx2() noexcept {
+                static const bool avx2 = __builtin_cpu_supports("avx2");
+                return avx2 && (allowed_extensions.load(std::memory_order_relaxed) & Detail::random_use_avx2) != 0;
+            }
+
+            bool has_avx512() noexcept {
+                static const bool avx512 = __builtin_cpu_supports("avx512f");
+                return avx512 && (allowed_extensions.load(std::memory_order_relaxed) & Detail::random_use_avx512) != 0;
+            }
+
+            // Two sets of four lanes, interleaved to hide latency. There is
+            // no 64-bit multiply, but multiplying by 5 or 9 is a shift and
+            // add.
+
+            template <int N>
+            RS_SCI_AVX2_TARGET inline __m256i rotl64x4(__m256i x) noexcept {
+                return _mm256_or_si256(_mm256_slli_epi64(x, N), _mm256_srli_epi64(x, 64 - N));
+            }
+
+            RS_SCI_AVX2_TARGET inline void xoshiro_step_avx2(__m256i* s, uint64_t* out) noexcept {
+                __m256i x = _mm256_add_epi64(s[1], _mm256_slli_epi64(s[1], 2));
+                x = rotl64x4<7>(x);
+                x = _mm256_add_epi64(x, _mm256_slli_epi64(x, 3));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), x);
+                __m256i y = _mm256_slli_epi64(s[1], 17);
+                s[2] = _mm256_xor_si256(s[2], s[0]);
+                s[3] = _mm256_xor_si256(s[3], s[1]);
+                s[1] = _mm256_xor_si256(s[1], s[2]);
+                s[0] = _mm256_xor_si256(s[0], s[3]);
+                s[2] = _mm256_xor_si256(s[2], y);
+                s[3] = rotl64x4<45>(s[3]);
+            }
+
+            RS_SCI_AVX2_TARGET void xoshiro_x8_avx2(uint64_t (&s)[4][x8_lanes], uint64_t* out, size_t blocks) noexcept {
+                __m256i lo[4], hi[4];
+                for (int i = 0; i < 4; ++i) {
+                    lo[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s[i]));
+                    hi[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s[i] + 4));
+                }
+                for (size_t b = 0; b < blocks; ++b, out += x8_lanes) {
+                    xoshiro_step_avx2(lo, out);
+                    xoshiro_step_avx2(hi, out + 4);
+                }
+                for (int i = 0; i < 4; ++i) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(s[i]), lo[i]);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(s[i] + 4), hi[i]);
+                }
+            }
+
+            // All eight lanes in one register, with a native rotate. The
+            // masked forms of the shift and rotate intrinsics, with all lanes
+            // selected, avoid a spurious uninitialized value warning from
+            // GCC 12 on the unmasked forms.
+
+            constexpr __mmask8 all_lanes = 0xff;
+
+            RS_SCI_AVX512_TARGET void xoshiro_x8_avx512(uint64_t (&s)[4][x8_lanes], uint64_t* out, size_t blocks) noexcept {
+                __m512i v[4];
+                for (int i = 0; i < 4; ++i)
+                    v[i] = _mm512_loadu_si512(s[i]);
+                for (size_t b = 0; b < blocks; ++b, out += x8_lanes) {
+                    __m512i x = _mm512_add_epi64(v[1], _mm512_maskz_slli_epi64(all_lanes, v[1], 2));
+                    x = _mm512_maskz_rol_epi64(all_lanes, x, 7);
+                    x = _mm512_add_epi64(x, _mm512_maskz_slli_epi64(all_lanes, x, 3));
+                    _mm512_storeu_si512(out, x);
+                    __m512i y = _mm512_maskz_slli_epi64(all_lanes, v[1], 17);
+                    v[2] = _mm512_xor_si512(v[2], v[0]);
+                    v[3] = _mm512_xor_si512(v[3], v[1]);
+                    v[1] = _mm512_xor_si512(v[1], v[2]);
+                    v[0] = _mm512_xor_si512(v[0], v[3]);
+                    v[2] = _mm512_xor_si512(v[2], y);
+                    v[3] = _mm512_maskz_rol_epi64(all_lanes, v[3], 45);
+                }
+                for (int i = 0; i < 4; ++i)
+                    _mm512_storeu_si512(s[i], v[i]);
+            }
+
+        #endif
+
+    }
+
+    unsigned Detail::random_extensions() noexcept {
+        return allowed_extensions.load(std::memory_order_relaxed);
+    }
+
+    void Detail::set_random_extensions(unsigned mask) noexcept {
+        allowed_extensions.store(mask & random_use_all, std::memory_order_relaxed);
+    }
+
+    void Detail::xoshiro_x8_blocks(uint64_t (&state)[4][8], uint64_t* out, size_t blocks) noexcept {
+
+        #ifdef RS_SCI_RANDOM_X86
+            if (has_avx512()) {
+                xoshiro_x8_avx512(state, out, blocks);
+                return;
+            }
+            if (has_avx2()) {
+                xoshiro_x8_avx2(state, out, blocks);
+                return;
+            }
+        #endif
+
+        xoshiro_x8_scalar(state, out, blocks);
+
+    }
+
+    // Values left over from a partial block are kept in the buffer, so the
+    // sequence is the same however it is split between fill() and
+    // operator()
+
+    void XoshiroX8::fill(uint64_t* out, size_t n) noexcept {
+
+        size_t from_buffer = std::min(n, buffer_size - pos_);
+        std::copy_n(buffer_ + pos_, from_buffer, out);
+        pos_ += from_buffer;
+        out += from_buffer;
+        n -= from_buffer;
+
+        size_t blocks = n / lanes;
+        Detail::xoshiro_x8_blocks(state_, out, blocks);
+        out += blocks * lanes;
+        n -= blocks * lanes;
+
+        if (n > 0) {
+            refill();
+            std::copy_n(buffer_, n, out);
+            pos_ = n;
+        }
+
+    }
+
+    // Each lane is one jump (2^128 steps) ahead of the one before it
+
+    void XoshiroX8::seed(uint64_t s) noexcept {
+        Xoshiro rng(s);
+        for (size_t j = 0; j < lanes; ++j) {
+            if (j > 0)
+                rng.jump();
+            for (int i = 0; i < 4; ++i)
+                state_[i][j] = rng.state_[i];
+        }
+        pos_ = buffer_size;
+    }
+
+}
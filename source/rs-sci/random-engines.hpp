@@ -10,6 +10,7 @@
 #include <functional>
 #include <iterator>
 #include <type_traits>
+#include <vector>
 
 namespace RS::Sci {
 
@@ -17,12 +18,42 @@ namespace RS::Sci {
     // Pierre L'Ecuyer (1999), "Tables of Linear Congruential Generators of Different Sizes and Good Lattice Structure"
     // http://www.ams.org/journals/mcom/1999-68-225/S0025-5718-99-00996-5/S0025-5718-99-00996-5.pdf
 
+    namespace Detail {
+
+        constexpr uint32_t lcg32_a = 32'310'901ul;
+        constexpr uint32_t lcg32_c = 850'757'001ul;
+        constexpr uint64_t lcg64_a = 3'935'559'000'370'003'845ull;
+        constexpr uint64_t lcg64_c = 8'831'144'850'135'198'739ull;
+
+        // Apply x -> ax+c n times in O(log n) steps, by composing powers of
+        // the affine map (Brown 1994, "Random Number Generation with
+        // Arbitrary Strides"). The period is a power of two, so a negative
+        // offset is the same as its two's complement.
+
+        template <typename T>
+        constexpr T lcg_advance(T x, T a, T c, T n) noexcept {
+            T mul = 1;
+            T add = 0;
+            while (n != 0) {
+                if (n & 1) {
+                    mul = T(mul * a);
+                    add = T(add * a + c);
+                }
+                c = T((a + 1) * c);
+                a = T(a * a);
+                n >>= 1;
+            }
+            return T(mul * x + add);
+        }
+
+    }
+
     constexpr uint32_t lcg32(uint32_t x) noexcept {
-        return uint32_t(32'310'901ul * x + 850'757'001ul);
+        return uint32_t(Detail::lcg32_a * x + Detail::lcg32_c);
     }
 
     constexpr uint64_t lcg64(uint64_t x) noexcept {
-        return uint64_t(3'935'559'000'370'003'845ull * x + 8'831'144'850'135'198'739ull);
+        return uint64_t(Detail::lcg64_a * x + Detail::lcg64_c);
     }
 
     class Lcg32 {
@@ -31,6 +62,7 @@ namespace RS::Sci {
         constexpr Lcg32() noexcept {}
         explicit constexpr Lcg32(uint32_t s) noexcept: state_(s) {}
         constexpr uint32_t operator()() noexcept { state_ = lcg32(state_); return state_; }
+        constexpr void advance(int64_t offset) noexcept { state_ = Detail::lcg_advance(state_, Detail::lcg32_a, Detail::lcg32_c, uint32_t(offset)); }
         constexpr bool operator==(const Lcg32& rhs) const noexcept { return state_ == rhs.state_; }
         constexpr bool operator!=(const Lcg32& rhs) const noexcept { return state_ != rhs.state_; }
         constexpr void seed(uint32_t s) noexcept { state_ = s; }
@@ -46,6 +78,7 @@ namespace RS::Sci {
         constexpr Lcg64() noexcept {}
         explicit constexpr Lcg64(uint64_t s) noexcept: state_(s) {}
         uint64_t constexpr operator()() noexcept { state_ = lcg64(state_); return state_; }
+        void constexpr advance(int64_t offset) noexcept { state_ = Detail::lcg_advance(state_, Detail::lcg64_a, Detail::lcg64_c, uint64_t(offset)); }
         bool constexpr operator==(const Lcg64& rhs) const noexcept { return state_ == rhs.state_; }
         bool constexpr operator!=(const Lcg64& rhs) const noexcept { return state_ != rhs.state_; }
         void constexpr seed(uint64_t s) noexcept { state_ = s; }
@@ -175,6 +208,18 @@ namespace RS::Sci {
             return x;
         }
 
+        // Equivalent to 2^128 and 2^192 calls to operator()
+
+        constexpr void jump() noexcept {
+            constexpr uint64_t poly[] = { 0x180e'c6d3'3cfd'0abaull, 0xd5a6'1266'f0c9'392cull, 0xa958'2618'e03f'c9aaull, 0x39ab'dc45'29b1'661cull };
+            apply_jump(poly);
+        }
+
+        constexpr void long_jump() noexcept {
+            constexpr uint64_t poly[] = { 0x76e1'5d3e'fefd'cbbfull, 0xc500'4e44'1c52'2fb3ull, 0x7771'0069'854e'e241ull, 0x3910'9bb0'2acb'e635ull };
+            apply_jump(poly);
+        }
+
         constexpr void seed(uint64_t s = 0) noexcept {
             Detail::SplitMix64 sm(s);
             state_[0] = sm();
@@ -204,12 +249,131 @@ namespace RS::Sci {
 
     private:
 
+        friend class XoshiroX8;
+
         std::array<uint64_t, 4> state_;
 
+        // The state transition is linear over GF(2), so a jump of n steps is
+        // a polynomial in the transition applied to the state; the jump
+        // polynomials are precomputed for n = 2^128 and 2^192
+
+        constexpr void apply_jump(const uint64_t (&poly)[4]) noexcept {
+            std::array<uint64_t, 4> sum = {};
+            for (auto word: poly) {
+                for (int bit = 0; bit < 64; ++bit) {
+                    if ((word >> bit) & 1)
+                        for (int i = 0; i < 4; ++i)
+                            sum[i] ^= state_[i];
+                    (*this)();
+                }
+            }
+            state_ = sum;
+        }
+
+    };
+
+    // Eight independent Xoshiro256** generators, stepped together so they
+    // can run in parallel in vector registers. The output is interleaved:
+    // each group of eight values holds one value from each lane in order.
+    // The results are the same whichever instruction set is used.
+
+    namespace Detail {
+
+        void xoshiro_x8_blocks(uint64_t (&state)[4][8], uint64_t* out, size_t blocks) noexcept;
+
+        // The optional instruction set extensions XoshiroX8 may use, where
+        // the processor has them (all of them by default). The tests narrow
+        // this to check every code path on any machine. It can be changed at
+        // any time; every path gives the same results.
+
+        constexpr unsigned random_use_avx2 = 1;
+        constexpr unsigned random_use_avx512 = 2;
+        constexpr unsigned random_use_all = random_use_avx2 | random_use_avx512;
+
+        unsigned random_extensions() noexcept;
+        void set_random_extensions(unsigned mask) noexcept;
+
+    }
+
+    class XoshiroX8 {
+
+    public:
+
+        using result_type = uint64_t;
+
+        static constexpr size_t lanes = 8;
+
+        XoshiroX8() noexcept { seed(0); }
+        explicit XoshiroX8(uint64_t s) noexcept { seed(s); }
+
+        uint64_t operator()() noexcept {
+            if (pos_ == buffer_size)
+                refill();
+            return buffer_[pos_++];
+        }
+
+        void fill(uint64_t* out, size_t n) noexcept;
+        void seed(uint64_t s = 0) noexcept;
+
+        static constexpr uint64_t min() noexcept { return 0; }
+        static constexpr uint64_t max() noexcept { return ~ uint64_t(0); }
+
+    private:
+
+        // Single values are generated several blocks at a time, to spread
+        // the cost of loading and storing the state
+
+        static constexpr size_t buffer_blocks = 8;
+        static constexpr size_t buffer_size = lanes * buffer_blocks;
+
+        uint64_t state_[4][lanes]; // Word-major: state_[i][j] is word i of lane j
+        uint64_t buffer_[buffer_size];
+        size_t pos_ = buffer_size;
+
+        void refill() noexcept {
+            Detail::xoshiro_x8_blocks(state_, buffer_, buffer_blocks);
+            pos_ = 0;
+        }
+
     };
 
     // Default choice of RNG
 
     using StdRng = Pcg64;
 
+    // Non-overlapping streams for parallel use. Engine 0 is seeded normally;
+    // each later engine starts where the one before it would be after a
+    // fixed number of calls, so the streams are disjoint until one of them
+    // has been called that many times: 2^128 for Xoshiro, 2^62 for Pcg64,
+    // or the period divided by the number of engines for the LCGs.
+
+    template <typename RNG>
+    std::vector<RNG> disjoint_engines(uint64_t seed, size_t n) {
+
+        static_assert(std::is_same_v<RNG, Lcg32> || std::is_same_v<RNG, Lcg64>
+            || std::is_same_v<RNG, Pcg64> || std::is_same_v<RNG, Xoshiro>,
+            "Engine type does not support disjoint streams");
+
+        std::vector<RNG> engines;
+        engines.reserve(n);
+        RNG rng(static_cast<typename RNG::result_type>(seed));
+
+        for (size_t i = 0; i < n; ++i) {
+            if (i > 0) {
+                if constexpr (std::is_same_v<RNG, Lcg32>)
+                    rng.advance(int64_t((uint64_t(1) << 32) / n));
+                else if constexpr (std::is_same_v<RNG, Lcg64>)
+                    rng.advance(int64_t(~ uint64_t(0) / n));
+                else if constexpr (std::is_same_v<RNG, Pcg64>)
+                    rng.advance(int64_t(1) << 62);
+                else
+                    rng.jump();
+            }
+            engines.push_back(rng);
+        }
+
+        return engines;
+
+    }
+
 }
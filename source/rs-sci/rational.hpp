@@ -1,5 +1,6 @@
 #pragma once
 
+#include "rs-sci/hash.hpp"
 #include "rs-format/format.hpp"
 #include "rs-format/string.hpp"
 #include "rs-graphics-core/maths.hpp"
@@ -10,6 +11,7 @@
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace RS::Sci {
@@ -26,6 +28,12 @@ namespace RS::Sci {
 
         bool parse_rational(const std::string& s, std::vector<std::string>& parts, bool& neg) noexcept;
 
+        template <typename T, typename = void>
+        struct HasLegacyHash: std::false_type {};
+
+        template <typename T>
+        struct HasLegacyHash<T, std::void_t<decltype(std::declval<const T&>().legacy_hash())>>: std::true_type {};
+
     }
 
     template <typename T>
@@ -91,6 +99,7 @@ namespace RS::Sci {
         constexpr T ceil() const noexcept;
         constexpr T round() const noexcept;
         size_t hash() const noexcept;
+        size_t legacy_hash() const noexcept;
         constexpr bool is_integer() const noexcept { return den_ == 1; }
         constexpr Ratio reciprocal() const noexcept;
         constexpr int sign() const noexcept { return num_ > 0 ? 1 : num_ == 0 ? 0 : -1; }
@@ -146,10 +155,30 @@ namespace RS::Sci {
             return q;
         }
 
+        // Plain integers are hashed directly as a pair; other types are
+        // hashed through their own hash values
+
         template <typename T>
         size_t Ratio<T>::hash() const noexcept {
-            size_t h1 = std::hash<T>()(num_);
-            size_t h2 = std::hash<T>()(den_);
+            if constexpr (std::has_unique_object_representations_v<T>) {
+                T parts[2] = {num_, den_};
+                return size_t(bulk_hash64(parts, sizeof(parts)));
+            } else {
+                size_t parts[2] = {std::hash<T>()(num_), std::hash<T>()(den_)};
+                return size_t(bulk_hash64(parts, sizeof(parts)));
+            }
+        }
+
+        template <typename T>
+        size_t Ratio<T>::legacy_hash() const noexcept {
+            size_t h1, h2;
+            if constexpr (Detail::HasLegacyHash<T>::value) {
+                h1 = num_.legacy_hash();
+                h2 = den_.legacy_hash();
+            } else {
+                h1 = std::hash<T>()(num_);
+                h2 = std::hash<T>()(den_);
+            }
             return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
         }
 
@@ -2,9 +2,14 @@
 #include "rs-format/format.hpp"
 #include "rs-format/string.hpp"
 #include "rs-unit-test.hpp"
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <numeric>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 
 using namespace RS::Format;
 using namespace RS::Sci;
@@ -45,6 +50,41 @@ void test_rs_sci_hash_siphash() {
 
 }
 
+void test_rs_sci_hash_siphash13() {
+
+    // Python's hash() for bytes objects uses SipHash-1-3, with a zero key
+    // if PYTHONHASHSEED=0
+
+    SipHash13 sip;
+    std::array<uint8_t, 64> in;
+    std::iota(in.begin(), in.end(), uint8_t(0));
+    uint64_t out = 0;
+
+    TRY(out = sip("a", 1));             TEST_EQUAL(out, 4'644'417'185'603'328'019ull);
+    TRY(out = sip("abcdefgh", 8));      TEST_EQUAL(out, 4'574'395'652'268'504'554ull);
+    TRY(out = sip("Hello world", 11));  TEST_EQUAL(out, 12'762'405'739'533'013'255ull);
+    TRY(out = sip(in.data(), 64));      TEST_EQUAL(out, 8'493'894'268'803'903'686ull);
+
+}
+
+void test_rs_sci_hash_halfsiphash() {
+
+    static constexpr std::array<uint32_t, 8> vectors_hsip32 = {{
+        0x5b9f'35a9u, 0xb85a'4727u, 0x03a6'62fau, 0x04e7'fe8au, 0x8946'6e2au, 0x69b6'fac5u, 0x23fc'6358u, 0xc563'cf8bu,
+    }};
+
+    HalfSipHash sip(0x0302'0100u, 0x0706'0504u);
+    std::array<uint8_t, 64> in;
+    std::iota(in.begin(), in.end(), uint8_t(0));
+    uint32_t out = 0;
+
+    for (int i = 0; i < 8; ++i) {
+        TRY(out = sip(in.data(), i));
+        TEST_EQUAL(out, vectors_hsip32[i]);
+    }
+
+}
+
 namespace {
 
     const std::string text1 = "Hello world";
@@ -100,6 +140,22 @@ namespace {
         TRY(hex = format_object(result, "xz"));
         TEST_EQUAL(hex, result2);
 
+        // Clearing an open hash discards the partial input
+
+        TRY(hash.add(text1));
+        TRY(hash.clear());
+        TRY(hash.add(text2));
+        TRY(result = hash.get());
+        TRY(hex = format_object(result, "xz"));
+        TEST_EQUAL(hex, result2);
+
+        // Destroying an open hash
+
+        {
+            H open_hash;
+            TRY(open_hash.add(text1));
+        }
+
     }
 
 }
@@ -139,3 +195,331 @@ void test_rs_sci_hash_sha512() {
     );
 
 }
+
+namespace {
+
+    template <typename H>
+    void run_digest_tests() {
+
+        H hash;
+        typename H::digest_type digest;
+        std::string result;
+
+        TEST_EQUAL(H::digest_bytes, hash.bytes());
+        TEST_EQUAL(sizeof(digest), hash.bytes());
+
+        for (auto& text: { text1, text2, text1 }) {
+            TRY(result = hash(text));
+            TRY(hash(text.data(), text.size(), digest));
+            TEST(std::memcmp(digest.data(), result.data(), digest.size()) == 0);
+            TRY(hash.clear());
+            TRY(hash.add(text));
+            TRY(digest = hash.digest());
+            TEST(std::memcmp(digest.data(), result.data(), digest.size()) == 0);
+            TRY(result = hash.get());
+            TEST(std::memcmp(digest.data(), result.data(), digest.size()) == 0);
+        }
+
+    }
+
+}
+
+void test_rs_sci_hash_digest() {
+
+    run_digest_tests<MD5>();
+    run_digest_tests<SHA1>();
+    run_digest_tests<SHA256>();
+    run_digest_tests<SHA512>();
+
+    SHA256 hash;
+    SHA256::digest_type digest;
+    std::string hex;
+
+    TRY(hash(nullptr, 0, digest));
+    TRY(hex = format_object(std::string(digest.begin(), digest.end()), "xz"));
+    TEST_EQUAL(hex, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+}
+
+namespace {
+
+    template <typename H>
+    void run_block_boundary_tests(const std::string& million_a, const std::string& sequence) {
+
+        H hash;
+        std::string data, expect, result, hex;
+
+        data.assign(1'000'000, 'a');
+        TRY(result = hash(data));
+        TRY(hex = format_object(result, "xz"));
+        TEST_EQUAL(hex, million_a);
+
+        TRY(hash.clear());
+        for (size_t pos = 0; pos < data.size(); pos += 1000)
+            TRY(hash.add(data.data() + pos, 1000));
+        TRY(result = hash.get());
+        TRY(hex = format_object(result, "xz"));
+        TEST_EQUAL(hex, million_a);
+
+        data.clear();
+        for (int i = 0; i < 1000; ++i)
+            data += char(i % 251);
+        TRY(expect = hash(data));
+        TRY(hex = format_object(expect, "xz"));
+        TEST_EQUAL(hex, sequence);
+
+        // Split at every point near a block boundary
+
+        for (size_t split = 0; split <= 260; ++split) {
+            TRY(hash.clear());
+            TRY(hash.add(data.data(), split));
+            TRY(hash.add(data.data() + split, data.size() - split));
+            TRY(result = hash.get());
+            TEST_EQUAL(result, expect);
+        }
+
+        // Every length across the padding boundaries, one shot and bytewise
+
+        for (size_t len = 1; len <= 260; ++len) {
+            TRY(expect = hash(data.data(), len));
+            TRY(hash.clear());
+            for (size_t i = 0; i < len; ++i)
+                TRY(hash.add(data.data() + i, 1));
+            TRY(result = hash.get());
+            TEST_EQUAL(result, expect);
+        }
+
+    }
+
+}
+
+void test_rs_sci_hash_sha2_block_boundaries() {
+
+    run_block_boundary_tests<SHA256>(
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+        "4e4c294b331f7a2099a379bec34b9f9fc03dc46ab465d998f4d683da53487e6d"
+    );
+
+    run_block_boundary_tests<SHA512>(
+        "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b",
+        "5096498d96f50f9a137c4db5b8b0cd38383ad55350fb5a98805fedc31fa1262f1f0cf4d6f12d7ecd8dedd933a4c9126344fe22e937a8ad35fdeae1e876ae698b"
+    );
+
+}
+
+void test_rs_sci_hash_batch() {
+
+    static constexpr uint64_t key0 = 0x0706050403020100ull;
+    static constexpr uint64_t key1 = 0x0f0e0d0c0b0a0908ull;
+
+    SipHash sip(key0, key1);
+    SipHash13 sip13(key0, key1);
+    SHA256 sha;
+    std::string pool;
+
+    for (int i = 0; i < 2000; ++i)
+        pool += char((i * 37 + 11) % 256);
+
+    // Mixed lengths, including empty messages and messages much longer
+    // than the others, for every batch size up to a few multiples of the
+    // number of lanes
+
+    for (size_t count = 0; count <= 40; ++count) {
+
+        std::vector<const void*> ptrs;
+        std::vector<size_t> lens;
+
+        for (size_t i = 0; i < count; ++i) {
+            size_t len = (i * 53 + count * 7) % (count % 3 == 0 ? 300 : 70);
+            if (i % 11 == 5)
+                len += 1000;
+            ptrs.push_back(pool.data() + (i * 17) % 500);
+            lens.push_back(len);
+        }
+
+        std::vector<uint64_t> sip_out(count);
+        std::vector<uint64_t> sip13_out(count);
+        std::vector<SHA256::digest_type> sha_out(count);
+
+        TRY(sip.hash_batch(ptrs.data(), lens.data(), count, sip_out.data()));
+        TRY(sip13.hash_batch(ptrs.data(), lens.data(), count, sip13_out.data()));
+        TRY(SHA256::hash_batch(ptrs.data(), lens.data(), count, sha_out.data()));
+
+        for (size_t i = 0; i < count; ++i) {
+            SHA256::digest_type expect;
+            TEST_EQUAL(sip_out[i], sip(ptrs[i], lens[i]));
+            TEST_EQUAL(sip13_out[i], sip13(ptrs[i], lens[i]));
+            TRY(sha(ptrs[i], lens[i], expect));
+            TEST(sha_out[i] == expect);
+        }
+
+    }
+
+}
+
+void test_rs_sci_hash_bulk_hash() {
+
+    struct sample {
+        size_t len;
+        uint64_t hash64;
+        uint64_t seeded64;
+        uint64_t high128;
+    };
+
+    static const std::vector<sample> samples = {
+        { 0,     0x0409'638e'e2bd'e459ull,  0xfe71'846e'c21f'dd78ull,  0xd99f'0cc8'e1b8'0c02ull },
+        { 1,     0xfbe5'af10'e5f8'bd85ull,  0x8806'0614'0af5'800cull,  0x8944'cd3d'e351'f1dcull },
+        { 3,     0xf971'e76c'3509'6d43ull,  0x9df4'38f0'91cc'38b2ull,  0x4f4b'5455'0879'd97cull },
+        { 4,     0xed0d'4340'e81b'7c4dull,  0xc9d0'f4b9'6342'0dfdull,  0x9f7b'dcd3'6cad'b0a0ull },
+        { 8,     0xb425'a02f'871e'b75full,  0x4fb3'ef56'a732'b875ull,  0xe0db'd948'708d'74e4ull },
+        { 16,    0xff5a'e257'316b'07b5ull,  0x7052'4bbc'4ec4'8758ull,  0x5042'a3c0'a244'8fa3ull },
+        { 17,    0xed17'f149'2bf1'51bfull,  0x2a8a'13b0'9906'eb0eull,  0xd2a1'34ce'5270'9cfaull },
+        { 32,    0x9068'766f'8d04'1546ull,  0xf54e'8098'd499'02fbull,  0x6288'908f'8825'ae03ull },
+        { 33,    0x586e'72a4'3b0a'572dull,  0xed29'8f71'3b00'917full,  0xb9d2'4a52'4780'd11dull },
+        { 100,   0x74fa'8559'4b1f'ad00ull,  0x0510'af2a'25aa'1e79ull,  0xc765'f1b4'5a93'7f54ull },
+        { 256,   0xcdc4'6506'f80f'b659ull,  0x3fa8'0665'48e7'ceddull,  0xcf4a'8fa1'4581'134full },
+        { 257,   0xd3cb'bd88'c13f'1c66ull,  0xa88a'c596'ed0d'425bull,  0x1659'985d'e22a'eb2dull },
+        { 1024,  0x4b17'7b58'dfd2'8c8bull,  0x3fe4'1c43'1a3f'3bf7ull,  0x8b5e'a596'f41c'755bull },
+        { 1025,  0x68a5'71d3'f0d9'55baull,  0xdac0'daad'a97a'fc78ull,  0x3f83'71a2'fdd0'0047ull },
+        { 5000,  0xfa4c'89a3'25fc'8babull,  0x0a9e'3788'd7e5'2967ull,  0x97f9'3495'adce'52ebull },
+    };
+
+    std::vector<uint8_t> in(5000);
+    uint64_t h = 0;
+    Hash128 h2 = {};
+
+    for (size_t i = 0; i < in.size(); ++i)
+        in[i] = uint8_t(i % 251);
+
+    for (auto& s: samples) {
+        TRY(h = bulk_hash64(in.data(), s.len));          TEST_EQUAL(h, s.hash64);
+        TRY(h = bulk_hash64(in.data(), s.len, 12345));   TEST_EQUAL(h, s.seeded64);
+        TRY(h2 = bulk_hash128(in.data(), s.len));        TEST_EQUAL(h2[0], s.hash64);  TEST_EQUAL(h2[1], s.high128);
+    }
+
+    // Changing any one bit must change the hash
+
+    std::vector<uint64_t> hashes;
+
+    for (size_t len: {5, 24, 200, 700, 2100}) {
+        hashes.clear();
+        hashes.push_back(bulk_hash64(in.data(), len));
+        for (size_t i = 0; i < len; i += 7) {
+            for (int bit = 0; bit < 8; bit += 3) {
+                in[i] ^= uint8_t(1 << bit);
+                hashes.push_back(bulk_hash64(in.data(), len));
+                in[i] ^= uint8_t(1 << bit);
+            }
+        }
+        std::sort(hashes.begin(), hashes.end());
+        TEST(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+    }
+
+}
+
+void test_rs_sci_hash_bulk_hasher() {
+
+    std::string s = "Hello world";
+    std::vector<uint32_t> v = {1, 2, 3, 4, 5};
+    uint64_t x = 0x0123'4567'89ab'cdefull;
+    size_t h = 0;
+
+    BulkHasher<std::string> hs;
+    BulkHasher<std::string_view> hsv;
+    BulkHasher<std::vector<uint32_t>> hv;
+    BulkHasher<uint64_t> hx;
+    BulkHasher<std::string> hs_seeded(42);
+
+    TEST_EQUAL(hs.seed(), 0u);
+    TEST_EQUAL(hs_seeded.seed(), 42u);
+
+    TRY(h = hs(s));                TEST_EQUAL(h, size_t(bulk_hash64(s.data(), s.size())));
+    TRY(h = hsv(s));               TEST_EQUAL(h, size_t(bulk_hash64(s.data(), s.size())));
+    TRY(h = hv(v));                TEST_EQUAL(h, size_t(bulk_hash64(v.data(), 4 * v.size())));
+    TRY(h = hx(x));                TEST_EQUAL(h, size_t(bulk_hash64(&x, 8)));
+    TRY(h = hs_seeded(s));         TEST_EQUAL(h, size_t(bulk_hash64(s.data(), s.size(), 42)));
+    TEST(hs_seeded(s) != hs(s));
+
+    std::unordered_set<std::string, BulkHasher<std::string>> set(0, BulkHasher<std::string>(99));
+
+    for (int i = 0; i < 1000; ++i)
+        TRY(set.insert(std::to_string(i)));
+
+    TEST_EQUAL(set.size(), 1000u);
+    TEST_EQUAL(set.hash_function().seed(), 99u);
+    TEST_EQUAL(set.count("999"), 1u);
+    TEST_EQUAL(set.count("1000"), 0u);
+
+}
+
+void test_rs_sci_hash_instruction_sets() {
+
+    // Every combination of the optional instruction set extensions must
+    // give the same results as the portable code, whatever the processor
+    // actually has
+
+    static constexpr uint64_t key0 = 0x0706050403020100ull;
+    static constexpr uint64_t key1 = 0x0f0e0d0c0b0a0908ull;
+
+    static const std::vector<unsigned> masks = {
+        RS::Sci::Detail::hash_use_all,
+        RS::Sci::Detail::hash_use_sha,
+        RS::Sci::Detail::hash_use_avx2,
+        0,
+    };
+
+    SipHash sip(key0, key1);
+    SHA256 sha;
+    std::string pool;
+    std::vector<const void*> ptrs;
+    std::vector<size_t> lens;
+
+    for (int i = 0; i < 3000; ++i)
+        pool += char((i * 37 + 11) % 256);
+
+    for (size_t i = 0; i < 40; ++i) {
+        ptrs.push_back(pool.data() + (i * 17) % 500);
+        lens.push_back(i % 7 == 3 ? 1000 + i * 31 : (i * 53) % 300);
+    }
+
+    size_t count = ptrs.size();
+    std::vector<uint64_t> sip_expect(count), sip_out(count);
+    std::vector<SHA256::digest_type> sha_expect(count), sha_out(count);
+    std::vector<Hash128> bulk_expect(count);
+    Hash128 bulk_out = {};
+
+    TRY(RS::Sci::Detail::set_hash_extensions(0));
+    TEST_EQUAL(RS::Sci::Detail::hash_extensions(), 0u);
+    TEST(! SHA256::hardware_accelerated());
+
+    for (size_t i = 0; i < count; ++i) {
+        TRY(sip_expect[i] = sip(ptrs[i], lens[i]));
+        TRY(sha(ptrs[i], lens[i], sha_expect[i]));
+        TRY(bulk_expect[i] = bulk_hash128(ptrs[i], lens[i]));
+    }
+
+    for (auto mask: masks) {
+
+        TRY(RS::Sci::Detail::set_hash_extensions(mask));
+        TEST_EQUAL(RS::Sci::Detail::hash_extensions(), mask);
+
+        for (size_t n: {count, size_t(8), size_t(3)}) {
+            TRY(sip.hash_batch(ptrs.data(), lens.data(), n, sip_out.data()));
+            TRY(SHA256::hash_batch(ptrs.data(), lens.data(), n, sha_out.data()));
+            for (size_t i = 0; i < n; ++i) {
+                TEST_EQUAL(sip_out[i], sip_expect[i]);
+                TEST(sha_out[i] == sha_expect[i]);
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            TRY(sha(ptrs[i], lens[i], sha_out[i]));          TEST(sha_out[i] == sha_expect[i]);
+            TRY(bulk_out = bulk_hash128(ptrs[i], lens[i]));  TEST(bulk_out == bulk_expect[i]);
+        }
+
+    }
+
+    TRY(RS::Sci::Detail::set_hash_extensions(RS::Sci::Detail::hash_use_all));
+    TEST_EQUAL(RS::Sci::Detail::hash_extensions(), RS::Sci::Detail::hash_use_all);
+
+}
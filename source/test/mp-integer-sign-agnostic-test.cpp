@@ -1,9 +1,14 @@
 #include "rs-sci/mp-integer.hpp"
+#include "rs-format/format.hpp"
 #include "rs-unit-test.hpp"
 #include <algorithm>
+#include <functional>
+#include <string>
 #include <tuple>
 #include <unordered_set>
+#include <vector>
 
+using namespace RS::Format;
 using namespace RS::Sci;
 using namespace RS::Sci::Literals;
 
@@ -83,3 +88,106 @@ void test_rs_sci_mp_integer_hash_set() {
     TEST_EQUAL(iset.size(), 10u);
 
 }
+
+void test_rs_sci_mp_integer_hash_limb_width() {
+
+    // Hash values are defined in terms of little endian bytes, whatever the
+    // limb width
+
+    using B = std::vector<uint8_t>;
+
+    auto bytes_hash = [] (const B& b, uint64_t seed = 0) { return size_t(bulk_hash64(b.data(), b.size(), seed)); };
+
+    TEST_EQUAL(MPN().hash(), bytes_hash({}));
+    TEST_EQUAL(MPN(0x12345678).hash(), bytes_hash({0x78, 0x56, 0x34, 0x12}));
+    TEST_EQUAL(MPN(0x123456789abcdef0ull).hash(), bytes_hash({0xf0, 0xde, 0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12}));
+    TEST_EQUAL(MPN("0x1'00000000'00000000").hash(), bytes_hash({0, 0, 0, 0, 0, 0, 0, 0, 1}));
+    TEST_EQUAL(MPN("0xabcdef01'00000000'00000000'00000000").hash(), bytes_hash({0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xef, 0xcd, 0xab}));
+    TEST_EQUAL(MPZ(42).hash(), MPN(42).hash());
+    TEST(MPZ(-42).hash() != MPZ(42).hash());
+
+    // Long values are hashed in 4096 byte pieces
+
+    B long_bytes(5000);
+
+    for (size_t i = 0; i < long_bytes.size(); ++i)
+        long_bytes[i] = uint8_t(i % 251 + 1);
+
+    MPN long_value = MPN::read_le(long_bytes.data(), long_bytes.size());
+    uint64_t long_hash = bulk_hash64(long_bytes.data(), 4096);
+    long_hash = bulk_hash64(long_bytes.data() + 4096, 904, long_hash);
+
+    TEST_EQUAL(long_value.hash(), size_t(long_hash));
+
+    // The legacy hash values are defined in terms of 32-bit words
+
+    using V = std::vector<uint32_t>;
+
+    TEST_EQUAL(MPN().legacy_hash(), hash_mix(V{}));
+    TEST_EQUAL(MPN(0x12345678).legacy_hash(), hash_mix(V{0x12345678}));
+    TEST_EQUAL(MPN(0x123456789abcdef0ull).legacy_hash(), hash_mix(V{0x9abcdef0, 0x12345678}));
+    TEST_EQUAL(MPN("0x1'00000000'00000000").legacy_hash(), hash_mix(V{0, 0, 1}));
+    TEST_EQUAL(MPN("0xabcdef01'00000000'00000000'00000000").legacy_hash(), hash_mix(V{0, 0, 0, 0xabcdef01}));
+    TEST_EQUAL(MPZ(-42).legacy_hash(), RS::Sci::Detail::mix_hashes(hash_mix(V{42}), std::hash<bool>()(true)));
+
+    MPQ q(MPZ(-3), MPZ(4));
+    size_t h1 = MPZ(-3).legacy_hash(), h2 = MPZ(4).legacy_hash();
+
+    TEST(q.hash() != MPQ(MPZ(3), MPZ(4)).hash());
+    TEST_EQUAL(q.legacy_hash(), h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2)));
+
+}
+
+void test_rs_sci_mp_integer_limb_storage() {
+
+    using LV = RS::Sci::Detail::LimbVector<uint32_t, 4>;
+
+    LV a, b, c;
+    std::string s;
+
+    TEST(a.empty());
+    TEST(a.is_inline());
+    TEST_EQUAL(a.capacity(), 4u);
+
+    TRY((a = {1, 2, 3, 4}));
+    TEST_EQUAL(a.size(), 4u);
+    TEST(a.is_inline());
+    TRY(a.push_back(5));
+    TEST_EQUAL(a.size(), 5u);
+    TEST(! a.is_inline());
+    TRY(s = format_range(a));  TEST_EQUAL(s, "[1,2,3,4,5]");
+
+    TRY((b = {10, 20}));
+    TRY(a.swap(b));
+    TEST(a.is_inline());
+    TEST(! b.is_inline());
+    TRY(s = format_range(a));  TEST_EQUAL(s, "[10,20]");
+    TRY(s = format_range(b));  TEST_EQUAL(s, "[1,2,3,4,5]");
+
+    TRY(c = std::move(b));
+    TEST(b.empty());
+    TEST(b.is_inline());
+    TRY(s = format_range(c));  TEST_EQUAL(s, "[1,2,3,4,5]");
+    TRY(c.erase(c.begin() + 1, c.begin() + 3));
+    TRY(s = format_range(c));  TEST_EQUAL(s, "[1,4,5]");
+    TRY(c.insert(c.begin(), 2, 0));
+    TRY(s = format_range(c));  TEST_EQUAL(s, "[0,0,1,4,5]");
+
+    TRY(b = a);
+    TRY(b.resize(6, 7));
+    TRY(s = format_range(b));  TEST_EQUAL(s, "[10,20,7,7,7,7]");
+    TRY(s = format_range(a));  TEST_EQUAL(s, "[10,20]");
+
+    MPN x = 1, y;
+    TRY(x <<= 255);
+    TRY(y = x - 1);
+    TEST_EQUAL(y.bits(), 255u);
+    TRY(y += x);
+    TEST_EQUAL(y.bits(), 256u);
+    TRY(y += x);
+    TEST_EQUAL(y.bits(), 257u);
+    TEST_EQUAL(y.str("x"), "17" + std::string(63, 'f'));
+    TRY(y >>= 200);
+    TEST_EQUAL(y.str("x"), "17" + std::string(13, 'f'));
+
+}
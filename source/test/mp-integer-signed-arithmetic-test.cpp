@@ -225,3 +225,43 @@ void test_rs_sci_mp_integer_signed_powers() {
     TRY(x = -10);  TRY(y = x.pow(30));  TEST_EQUAL(y.str(), "1000000000000000000000000000000");
 
 }
+
+void test_rs_sci_mp_integer_signed_fused_arithmetic() {
+
+    MPZ a, b, c, x;
+    std::string s;
+
+    TRY(a = MPZ("123456789123456789123456789123456789123456789"));
+    TRY(b = MPZ("1357913579135791357913579"));
+    TRY(c = MPZ("-987654321987654321"));
+
+    TRY(add(x, a, b));        TRY(s = to_string(x));  TEST_EQUAL(s, "123456789123456789124814702702592580481370368");
+    TRY(add(x, -a, b));       TRY(s = to_string(x));  TEST_EQUAL(s, "-123456789123456789122098875544320997765543210");
+    TRY(add(x, a, -a));       TRY(s = to_string(x));  TEST_EQUAL(s, "0");
+    TRY(subtract(x, b, a));   TRY(s = to_string(x));  TEST_EQUAL(s, "-123456789123456789122098875544320997765543210");
+    TRY(subtract(x, a, -b));  TRY(s = to_string(x));  TEST_EQUAL(s, "123456789123456789124814702702592580481370368");
+    TRY(subtract(x, c, c));   TRY(s = to_string(x));  TEST_EQUAL(s, "0");
+    TRY(multiply(x, b, c));   TRY(s = to_string(x));  TEST_EQUAL(s, "-1341149215319188994375843624322662843924859");
+
+    TRY(x = a);   TRY(addmul(x, b, c));    TRY(s = to_string(x));  TEST_EQUAL(s, "122115639908137600129080945499134126279531930");
+    TRY(x = a);   TRY(submul(x, b, c));    TRY(s = to_string(x));  TEST_EQUAL(s, "124797938338775978117832632747779451967381648");
+    TRY(x = -a);  TRY(addmul(x, b, c));    TRY(s = to_string(x));  TEST_EQUAL(s, "-124797938338775978117832632747779451967381648");
+    TRY(x = -a);  TRY(submul(x, b, c));    TRY(s = to_string(x));  TEST_EQUAL(s, "-122115639908137600129080945499134126279531930");
+    TRY(x = c);   TRY(addmul(x, b, b));    TRY(s = to_string(x));  TEST_EQUAL(s, "1843929288401375098661835358061508059786044934920");
+    TRY(x = c);   TRY(submul(x, -b, b));   TRY(s = to_string(x));  TEST_EQUAL(s, "1843929288401375098661835358061508059786044934920");
+    TRY(x = 0);   TRY(submul(x, b, c));    TRY(s = to_string(x));  TEST_EQUAL(s, "1341149215319188994375843624322662843924859");
+    TRY(x = 6);   TRY(submul(x, 2, 3));    TRY(s = to_string(x));  TEST_EQUAL(s, "0");
+    TRY(x = -6);  TRY(addmul(x, -2, -3));  TRY(s = to_string(x));  TEST_EQUAL(s, "0");
+    TRY(x = c);   TRY(addmul(x, x, x));    TRY(s = to_string(x));  TEST_EQUAL(s, "975461059740893156567748817802316720");
+
+    TRY(x = MPZ("340282366920938463463374607431768211456"));  TRY(x -= 1);  TRY(s = to_string(x));  TEST_EQUAL(s, "340282366920938463463374607431768211455");
+    TRY(x = MPZ("-340282366920938463463374607431768211456"));  TRY(x += 1);  TRY(s = to_string(x));  TEST_EQUAL(s, "-340282366920938463463374607431768211455");
+
+    TRY(x = powmod(MPZ(-2), 3, 5));                       TRY(s = to_string(x));  TEST_EQUAL(s, "2");
+    TRY(x = powmod(MPZ(-2), 3, -5));                      TRY(s = to_string(x));  TEST_EQUAL(s, "2");
+    TRY(x = powmod(MPZ(-123456789), 65537, 1000000007));  TRY(s = to_string(x));  TEST_EQUAL(s, "439416481");
+
+    TEST_THROW(powmod(MPZ(2), MPZ(-3), MPZ(7)),  std::domain_error);
+    TEST_THROW(powmod(MPZ(2), MPZ(3), MPZ(0)),   std::domain_error);
+
+}
@@ -1,7 +1,10 @@
 #include "rs-sci/mp-integer.hpp"
+#include "rs-sci/random-engines.hpp"
 #include "rs-format/format.hpp"
 #include "rs-unit-test.hpp"
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace RS::Format;
@@ -16,6 +19,13 @@ namespace {
         return format_string(s, "x");
     }
 
+    MPN random_mpn(Pcg64& rng, size_t words) {
+        std::vector<uint32_t> v(words);
+        for (auto& w: v)
+            w = uint32_t(rng());
+        return MPN::read_le(v.data(), 4 * words);
+    }
+
 }
 
 void test_rs_sci_mp_integer_unsigned_arithmetic() {
@@ -103,6 +113,157 @@ void test_rs_sci_mp_integer_unsigned_arithmetic() {
 
 }
 
+void test_rs_sci_mp_integer_unsigned_multiplication_algorithms() {
+
+    static constexpr size_t sizes[] = { 1, 2, 3, 5, 9, 17, 31, 32, 33, 64, 100, 159, 160, 161, 250, 400 };
+
+    Pcg64 rng(42);
+    MPN x, y, z, expect;
+
+    for (auto m: sizes) {
+        for (auto n: sizes) {
+            if (n > m)
+                continue;
+            TRY(x = random_mpn(rng, m));
+            TRY(y = random_mpn(rng, n));
+            TRY(expect = multiply(x, y, MulAlgorithm::schoolbook));
+            TRY(z = x * y);                                    TEST_EQUAL(z, expect);
+            TRY(z = y * x);                                    TEST_EQUAL(z, expect);
+            TRY(z = multiply(x, y, MulAlgorithm::karatsuba));  TEST_EQUAL(z, expect);
+            TRY(z = multiply(x, y, MulAlgorithm::toom3));      TEST_EQUAL(z, expect);
+            TRY(z = expect / x);                               TEST_EQUAL(z, y);
+        }
+    }
+
+    TRY(x = 1);
+    TRY(x <<= 10'000);
+    TRY(--x);
+    TRY(y = x);
+    TRY(expect = 1);
+    TRY(expect <<= 20'000);
+    TRY(expect -= x);
+    TRY(expect -= y);
+    TRY(expect -= 1);
+    TRY(z = multiply(x, y, MulAlgorithm::karatsuba));  TEST_EQUAL(z, expect);
+    TRY(z = multiply(x, y, MulAlgorithm::toom3));      TEST_EQUAL(z, expect);
+    TRY(z = multiply(x, 0, MulAlgorithm::toom3));      TEST_EQUAL(z, MPN());
+
+    // Sparse operands, where the Karatsuba sums have leading zeros
+
+    TRY(x = random_mpn(rng, 100));
+    TRY(y = 1);
+    TRY(y <<= 32 * 51);
+    TRY(++y);
+    TRY(expect = x);
+    TRY(expect <<= 32 * 51);
+    TRY(expect += x);
+    TRY(z = multiply(x, y, MulAlgorithm::karatsuba));  TEST_EQUAL(z, expect);
+    TRY(z = multiply(y, x, MulAlgorithm::karatsuba));  TEST_EQUAL(z, expect);
+    TRY(z = multiply(x, y, MulAlgorithm::toom3));      TEST_EQUAL(z, expect);
+
+}
+
+void test_rs_sci_mp_integer_unsigned_ntt_multiplication() {
+
+    static constexpr size_t sizes[] = { 1, 2, 3, 7, 64, 255, 256, 257, 1000, 1536, 4000 };
+
+    Pcg64 rng(86);
+    MPN x, y, z, expect;
+
+    for (auto m: sizes) {
+        for (auto n: sizes) {
+            if (n > m)
+                continue;
+            TRY(x = random_mpn(rng, m));
+            TRY(y = random_mpn(rng, n));
+            TRY(expect = multiply(x, y, MulAlgorithm::schoolbook));
+            TRY(z = multiply(x, y, MulAlgorithm::ntt));  TEST_EQUAL(z, expect);
+            TRY(z = multiply(y, x, MulAlgorithm::ntt));  TEST_EQUAL(z, expect);
+        }
+    }
+
+    // All bits set gives the largest possible convolution terms
+
+    for (auto n: { 1, 100, 4000 }) {
+        TRY(x = 1);
+        TRY(x <<= 32 * n);
+        TRY(--x);
+        TRY(expect = multiply(x, x, MulAlgorithm::schoolbook));
+        TRY(z = multiply(x, x, MulAlgorithm::ntt));  TEST_EQUAL(z, expect);
+        TRY(z = x * x);                              TEST_EQUAL(z, expect);
+    }
+
+    TRY(x = random_mpn(rng, 20'000));
+    TRY(y = random_mpn(rng, 3'000));
+    TRY(expect = multiply(x, y, MulAlgorithm::toom3));
+    TRY(z = x * y);                              TEST_EQUAL(z, expect);
+    TRY(z = multiply(x, y, MulAlgorithm::ntt));  TEST_EQUAL(z, expect);
+    TRY(z = multiply(x, 0, MulAlgorithm::ntt));  TEST_EQUAL(z, MPN());
+
+}
+
+void test_rs_sci_mp_integer_unsigned_division() {
+
+    static constexpr size_t sizes[] = { 1, 2, 3, 4, 7, 16, 33, 100, 257 };
+
+    Pcg64 rng(99);
+    MPN x, y, z, q, r;
+    std::pair<MPN, MPN> qr;
+
+    for (auto m: sizes) {
+        for (auto n: sizes) {
+            if (n > m)
+                continue;
+            for (int shift: { 0, 1, 17, 31 }) {
+                TRY(x = random_mpn(rng, m));
+                TRY(y = random_mpn(rng, n) >> shift);
+                if (! y)
+                    continue;
+                TRY(qr = divide(x, y));
+                TEST(qr.second < y);
+                TRY(z = qr.first * y + qr.second);
+                TEST_EQUAL(z, x);
+            }
+        }
+    }
+
+    // Cases that need the add back step in Knuth's algorithm
+
+    TRY(x = MPN("0x8000'0000'0000'0000'0000'0003"));
+    TRY(y = MPN("0x2000'0000'0000'0000'0000'0001"));
+    TRY(qr = divide(x, y));
+    TEST_EQUAL(qr.first.str("x"), "3");
+    TEST_EQUAL(qr.second.str("x"), "200000000000000000000000");
+
+    TRY(x = MPN("0x7fff'0000'8000'0000'0000'0000'0000'0000"));
+    TRY(y = MPN("0x8000'0000'0000'0000'0001"));
+    TRY(qr = divide(x, y));
+    TEST_EQUAL(qr.first.str("x"), "fffe0000ffff");
+    TEST_EQUAL(qr.second.str("x"), "7fffffff0001ffff0001");
+
+    TRY(x = MPN("0x8000'0000'0000'0000'0000'0000'fffe'0000'0000'0000"));
+    TRY(y = MPN("0x8000'0000'0000'0000'ffff'ffff'ffff'ffff"));
+    TRY(qr = divide(x, y));
+    TRY(z = qr.first * y + qr.second);
+    TEST_EQUAL(z, x);
+    TEST(qr.second < y);
+
+    // Single word divisors
+
+    TRY(x = MPN("123456789123456789123456789123456789123456789"));
+    TRY(q = x / 10);      TEST_EQUAL(q, MPN("12345678912345678912345678912345678912345678"));
+    TRY(r = x % 10);      TEST_EQUAL(r, MPN(9));
+    TRY(q = x / 0xffff'ffffu);
+    TRY(r = x % 0xffff'ffffu);
+    TEST_EQUAL(q * 0xffff'ffffu + r, x);
+    TRY(q = x / 0xffff'ffff'ffff'ffffull);
+    TRY(r = x % 0xffff'ffff'ffff'ffffull);
+    TEST_EQUAL(q * 0xffff'ffff'ffff'ffffull + r, x);
+
+    TEST_THROW(x / MPN(), std::domain_error);
+
+}
+
 void test_rs_sci_mp_integer_unsigned_arithmetic_powers() {
 
     MPN x, y;
@@ -187,6 +348,15 @@ void test_rs_sci_mp_integer_unsigned_bit_operations() {
     TRY(s = to_string(z));  TEST_EQUAL(s, "17134975606245761295");
     TRY(s = z.str("x"));    TEST_EQUAL(s, "edcba9876543210f");
 
+    // Right operand longer than the left
+
+    TRY(y = MPN("0x1'0000'0000'0000'0000'0000'0000'0000'0005"));
+    TRY(z = MPN(3) | y);  TRY(s = z.str("x"));  TEST_EQUAL(s, "100000000000000000000000000000007");
+    TRY(z = MPN(3) ^ y);  TRY(s = z.str("x"));  TEST_EQUAL(s, "100000000000000000000000000000006");
+    TRY(z = MPN() | y);   TRY(s = z.str("x"));  TEST_EQUAL(s, "100000000000000000000000000000005");
+    TRY(z = MPN() | 1);   TRY(s = z.str("x"));  TEST_EQUAL(s, "1");
+    TRY(y = 0xffffffffffffffffull);
+
     TRY(z = x >> 0);   TRY(s = z.str("x"));  TEST_EQUAL(s, "123456789abcdef0");
     TRY(z = x >> 1);   TRY(s = z.str("x"));  TEST_EQUAL(s, "91a2b3c4d5e6f78");
     TRY(z = x >> 2);   TRY(s = z.str("x"));  TEST_EQUAL(s, "48d159e26af37bc");
@@ -317,3 +487,116 @@ void test_rs_sci_mp_integer_unsigned_byte_operations() {
     TRY(a = MPN::read_le(v.data(), v.size()));  TEST_EQUAL(a.str("x"), "ffeeddccbbaa998877665544332211");
 
 }
+
+void test_rs_sci_mp_integer_unsigned_fused_arithmetic() {
+
+    static constexpr size_t sizes[] = { 0, 1, 2, 3, 5, 16, 40, 100 };
+
+    Pcg64 rng(123);
+    MPN w, x, y, z, ref;
+
+    for (auto m: sizes) {
+        for (auto n: sizes) {
+            for (auto k: { size_t(0), size_t(1), size_t(7), m + n + 1 }) {
+
+                TRY(x = random_mpn(rng, m));
+                TRY(y = random_mpn(rng, n));
+                TRY(w = random_mpn(rng, k));
+
+                TRY(z = w);  TRY(add(z, x, y));       TRY(ref = x);  TRY(ref += y);      TEST_EQUAL(z, ref);
+                TRY(z = w);  TRY(multiply(z, x, y));  TRY(ref = x * y);                  TEST_EQUAL(z, ref);
+                TRY(z = w);  TRY(addmul(z, x, y));    TRY(ref = w);  TRY(ref += x * y);  TEST_EQUAL(z, ref);
+                TRY(submul(z, x, y));                                                    TEST_EQUAL(z, w);
+
+                if (x >= y) {
+                    TRY(z = w);  TRY(subtract(z, x, y));  TRY(ref = x);  TRY(ref -= y);  TEST_EQUAL(z, ref);
+                }
+
+            }
+        }
+    }
+
+    // Destination aliasing an operand
+
+    TRY(x = random_mpn(rng, 50));
+    TRY(y = random_mpn(rng, 30));
+
+    TRY(z = x);  TRY(add(z, z, y));       TEST_EQUAL(z, x + y);
+    TRY(z = y);  TRY(add(z, x, z));       TEST_EQUAL(z, x + y);
+    TRY(z = x);  TRY(subtract(z, z, y));  TEST_EQUAL(z, x - y);
+    TRY(z = y);  TRY(subtract(z, x, z));  TEST_EQUAL(z, x - y);
+    TRY(z = x);  TRY(multiply(z, z, z));  TEST_EQUAL(z, x * x);
+    TRY(z = x);  TRY(addmul(z, z, y));    TEST_EQUAL(z, x + x * y);
+    TRY(z = y);  TRY(addmul(z, x, z));    TEST_EQUAL(z, y + x * y);
+    TRY(z = x);  TRY(addmul(z, z, z));    TEST_EQUAL(z, x + x * x);
+    TRY(z = x * x);  TRY(submul(z, x, x));  TEST(! z);
+
+    TRY(z = MPN(1) << 128);  TRY(subtract(z, z, 1));  TEST_EQUAL(z.str("x"), "ffffffffffffffffffffffffffffffff");
+
+    TRY(x = MPN("0xffff'ffff'ffff'ffff'ffff'ffff'ffff'ffff"));
+    TRY(z = 1);  TRY(addmul(z, x, x));  TEST_EQUAL(z.str("x"), "fffffffffffffffffffffffffffffffe00000000000000000000000000000002");
+    TRY(submul(z, x, 1));               TEST_EQUAL(z.str("x"), "fffffffffffffffffffffffffffffffd00000000000000000000000000000003");
+
+}
+
+void test_rs_sci_mp_integer_unsigned_modular_arithmetic() {
+
+    static constexpr size_t sizes[] = { 1, 2, 3, 8, 17, 40 };
+
+    Pcg64 rng(321);
+    MPN m, n, x, y, z, ref;
+    std::string s;
+
+    TRY(z = powmod(MPN(65), 17, 3233));                 TRY(s = to_string(z));  TEST_EQUAL(s, "2790");
+    TRY(z = powmod(MPN(2790), 2753, 3233));             TRY(s = to_string(z));  TEST_EQUAL(s, "65");
+    TRY(z = powmod(MPN(3), 200, MPN(1) << 64));         TRY(s = to_string(z));  TEST_EQUAL(s, "6627890308811632801");
+    TRY(z = powmod(MPN(5), 123, (MPN(1) << 128) + 2));  TRY(s = to_string(z));  TEST_EQUAL(s, "26878501902754594709712482684751052337");
+    TRY(z = powmod(MPN(7), MPN("100000000000000000000"), (MPN(1) << 89) - 1));
+    TRY(s = to_string(z));  TEST_EQUAL(s, "132908656697794360354515760");
+    TRY(z = powmod(MPN("12345678901234567890"), MPN("98765432109876543210"), MPN("1000000000000000000000000000057")));
+    TRY(s = to_string(z));  TEST_EQUAL(s, "254352563798918902598778017825");
+
+    TRY(m = (MPN(1) << 521) - 1);
+    TRY(z = powmod(MPN(3), m - 1, m));  TEST_EQUAL(z, MPN(1));
+    TRY(z = powmod(MPN(3), m, m));      TEST_EQUAL(z, MPN(3));
+
+    TRY(z = powmod(MPN(5), 0, 7));    TEST_EQUAL(z, MPN(1));
+    TRY(z = powmod(MPN(0), 0, 7));    TEST_EQUAL(z, MPN(1));
+    TRY(z = powmod(MPN(0), 5, 7));    TEST_EQUAL(z, MPN(0));
+    TRY(z = powmod(MPN(5), 10, 1));   TEST_EQUAL(z, MPN(0));
+    TRY(z = powmod(MPN(5), 0, 1));    TEST_EQUAL(z, MPN(0));
+    TEST_THROW(powmod(MPN(5), 10, 0), std::domain_error);
+    TEST_THROW(MontgomeryContext(10), std::invalid_argument);
+
+    for (auto k: sizes) {
+
+        TRY(m = random_mpn(rng, k) | 1);
+        MontgomeryContext mc;
+        TRY(mc = MontgomeryContext(m));
+        TEST_EQUAL(mc.modulus(), m);
+
+        for (int i = 0; i < 5; ++i) {
+            TRY(x = random_mpn(rng, k + i % 2));
+            TRY(y = random_mpn(rng, k));
+            TRY(n = random_mpn(rng, 1 + 4 * i));
+            TRY(z = mc.multiply(x, y));
+            TEST_EQUAL(z, x * y % m);
+            for (auto mod: { m, m + 1 }) {
+                TRY(ref = 1);
+                for (size_t b = n.bits() - 1; b != std::string::npos; --b) {
+                    TRY(ref = ref * ref % mod);
+                    if (n.get_bit(b))
+                        TRY(ref = ref * x % mod);
+                }
+                TRY(z = powmod(x, n, mod));
+                TEST_EQUAL(z, ref);
+                if (mod == m) {
+                    TRY(z = mc.pow(x, n));
+                    TEST_EQUAL(z, ref);
+                }
+            }
+        }
+
+    }
+
+}
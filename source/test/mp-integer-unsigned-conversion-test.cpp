@@ -1,9 +1,40 @@
 #include "rs-sci/mp-integer.hpp"
+#include "rs-sci/random-engines.hpp"
 #include "rs-unit-test.hpp"
 #include <string>
+#include <vector>
 
 using namespace RS::Sci;
 
+namespace {
+
+    MPN random_mpn(Pcg64& rng, size_t words) {
+        std::vector<uint32_t> v(words);
+        for (auto& w: v)
+            w = uint32_t(rng());
+        return MPN::read_le(v.data(), 4 * words);
+    }
+
+    // Simple quadratic conversion to check against
+
+    std::string reference_decimal(MPN x) {
+        static const MPN chunk = 1'000'000'000;
+        std::string s;
+        while (x) {
+            auto c = unsigned(x % chunk);
+            x /= chunk;
+            for (int i = 0; i < 9; ++i, c /= 10)
+                s += char('0' + c % 10);
+        }
+        while (s.size() > 1 && s.back() == '0')
+            s.pop_back();
+        if (s.empty())
+            s = "0";
+        return std::string(s.rbegin(), s.rend());
+    }
+
+}
+
 void test_rs_sci_mp_integer_unsigned_conversion_integers() {
 
     MPN x;
@@ -125,3 +156,55 @@ void test_rs_sci_mp_integer_unsigned_conversion_double() {
     TRY(x = MPN::from_double(1.23456789e40));  TRY(s = x.str());  TEST_MATCH(s, "^12345678\\d{33}$");
 
 }
+
+void test_rs_sci_mp_integer_unsigned_conversion_large_strings() {
+
+    Pcg64 rng(42);
+    MPN x, y;
+    std::string s;
+
+    for (size_t words: {1, 2, 10, 39, 40, 41, 63, 64, 65, 100, 129, 300, 1000, 2500}) {
+        TRY(x = random_mpn(rng, words));
+        TRY(s = x.str());
+        TEST_EQUAL(s, reference_decimal(x));
+        TRY(y = MPN(s));
+        TEST_EQUAL(y, x);
+        for (int base: {2, 3, 7, 8, 16, 32, 36}) {
+            std::string t;
+            for (MPN z = x; z; z /= base) {
+                auto d = unsigned(z % base);
+                t.insert(t.begin(), char(d < 10 ? '0' + d : 'a' + d - 10));
+            }
+            TRY(y = MPN(t, base));
+            TEST_EQUAL(y, x);
+            if (words >= 1000)
+                break;
+        }
+        TRY(s = x.str("x"));
+        TRY(y = MPN(s, 16));
+        TEST_EQUAL(y, x);
+        TRY(s = x.str("b"));
+        TEST_EQUAL(s.size(), x.bits());
+        TRY(y = MPN(s, 2));
+        TEST_EQUAL(y, x);
+    }
+
+    for (size_t n: {9, 10, 360, 361, 3000, 20000, 100000}) {
+        TRY(x = MPN(10).pow(n));
+        TRY(s = x.str());
+        TEST_EQUAL(s, "1" + std::string(n, '0'));
+        TRY(y = MPN(s));
+        TEST_EQUAL(y, x);
+        TRY(--x);
+        TRY(s = x.str());
+        TEST_EQUAL(s, std::string(n, '9'));
+        TRY(y = MPN(s));
+        TEST_EQUAL(y, x);
+    }
+
+    TRY(x = MPN("000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000012"));
+    TEST_EQUAL(x, MPN(12));
+    TRY(s = x.str("n8"));  TEST_EQUAL(s, "00000012");
+    TRY(s = x.str("x8"));  TEST_EQUAL(s, "0000000c");
+
+}
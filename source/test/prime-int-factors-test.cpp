@@ -1,6 +1,9 @@
 #include "rs-sci/prime.hpp"
+#include "rs-sci/random.hpp"
 #include "rs-format/format.hpp"
 #include "rs-unit-test.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -82,4 +85,113 @@ void test_rs_sci_prime_factorization_int() {
     TRY(m = prime_factors_map(123456789));  TRY(s = format_map(m));  TEST_EQUAL(s, "{3:2,3607:1,3803:1}");
     TRY(m = prime_factors_map(987654319));  TRY(s = format_map(m));  TEST_EQUAL(s, "{987654319:1}");
 
+    TRY(v = prime_factors(0));     TRY(s = format_range(v));  TEST_EQUAL(s, "[]");
+    TRY(v = prime_factors(-12));   TRY(s = format_range(v));  TEST_EQUAL(s, "[]");
+    TRY(m = prime_factors_map(0));    TRY(s = format_map(m));  TEST_EQUAL(s, "{}");
+    TRY(m = prime_factors_map(-12));  TRY(s = format_map(m));  TEST_EQUAL(s, "{}");
+
+}
+
+void test_rs_sci_prime_factorization_int64() {
+
+    std::vector<uint64_t> v;
+    std::map<uint64_t, uint64_t> m;
+    std::string s;
+
+    TRY(v = prime_factors(uint64_t(998'244'359'987'710'471u)));     TRY(s = format_range(v));  TEST_EQUAL(s, "[998244353,1000000007]");
+    TRY(v = prime_factors(uint64_t(18'446'743'979'220'271'189u)));  TRY(s = format_range(v));  TEST_EQUAL(s, "[4294967279,4294967291]");
+    TRY(v = prime_factors(uint64_t(18'446'744'030'759'878'681u)));  TRY(s = format_range(v));  TEST_EQUAL(s, "[4294967291,4294967291]");
+    TRY(v = prime_factors(uint64_t(18'446'744'073'709'551'557u)));  TRY(s = format_range(v));  TEST_EQUAL(s, "[18446744073709551557]");
+    TRY(v = prime_factors(uint64_t(18'446'744'073'709'551'615u)));  TRY(s = format_range(v));  TEST_EQUAL(s, "[3,5,17,257,641,65537,6700417]");
+    TRY(v = prime_factors(uint64_t(9'223'372'036'854'775'808u)));   TRY(s = format_range(v));  TEST_EQUAL(s, "[2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2]");
+
+    TRY(m = prime_factors_map(uint64_t(18'446'743'979'220'271'189u)));  TRY(s = format_map(m));  TEST_EQUAL(s, "{4294967279:1,4294967291:1}");
+    TRY(m = prime_factors_map(uint64_t(9'223'372'036'854'775'808u)));   TRY(s = format_map(m));  TEST_EQUAL(s, "{2:63}");
+    TRY(m = prime_factors_map(uint64_t(3'000'000'042'000'000'147u)));   TRY(s = format_map(m));  TEST_EQUAL(s, "{3:1,1000000007:2}");
+
+    // Check products of random primes
+
+    Pcg64 rng(42);
+    UniformInteger<uint64_t> dist(2, 1'000'000);
+
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t n = 1;
+        std::vector<uint64_t> expect;
+        for (;;) {
+            uint64_t p = next_prime(dist(rng));
+            if (n > ~ uint64_t(0) / p)
+                break;
+            n *= p;
+            expect.push_back(p);
+        }
+        std::sort(expect.begin(), expect.end());
+        TRY(v = prime_factors(n));
+        TEST_EQUAL(format_range(v), format_range(expect));
+    }
+
+}
+
+void test_rs_sci_prime_factorization_batch() {
+
+    FactorBatch<int> small;
+    std::string s;
+
+    static const std::vector<int> small_values = { 720, -5, 0, 1, 2, 97, 1001, 65536 };
+
+    TRY(small = factor_batch(small_values));
+    TEST_EQUAL(small.offsets.size(), small_values.size() + 1);
+    TRY(s = format_range(small.offsets));  TEST_EQUAL(s, "[0,7,7,7,7,8,9,12,28]");
+    TRY(s = format_range(small.factors));  TEST_EQUAL(s, "[2,2,2,2,3,3,5,2,97,7,11,13,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2]");
+
+    TRY(small = factor_batch(std::vector<int>()));
+    TRY(s = format_range(small.offsets));  TEST_EQUAL(s, "[0]");
+    TEST(small.factors.empty());
+
+    // Mixed 32 and 48 bit values, compared with prime_factors()
+
+    Pcg64 rng(42);
+    UniformInteger<uint64_t> dist32(0, 0xffff'ffff);
+    UniformInteger<uint64_t> dist48(0, 0xffff'ffff'ffff);
+    std::vector<uint64_t> values;
+
+    for (int i = 0; i < 5000; ++i) {
+        values.push_back(dist32(rng));
+        values.push_back(dist48(rng));
+    }
+
+    values.push_back(uint64_t(281'474'976'710'597u)); // Prime
+    values.push_back(uint64_t(281'474'641'166'387u)); // 16777199 * 16777213
+    values.push_back(uint64_t(18'446'743'979'220'271'189u)); // 4294967279 * 4294967291
+    values.push_back(uint64_t(18'446'744'073'709'551'615u));
+
+    std::vector<uint64_t> expect_offsets = { 0 };
+    std::vector<uint64_t> expect_factors;
+
+    for (auto n: values) {
+        auto f = prime_factors(n);
+        expect_factors.insert(expect_factors.end(), f.begin(), f.end());
+        expect_offsets.push_back(expect_factors.size());
+    }
+
+    for (size_t threads: { 0, 1, 2, 3 }) {
+        FactorBatch<uint64_t> batch;
+        TRY(batch = factor_batch(values, threads));
+        TEST_EQUAL(batch.offsets.size(), expect_offsets.size());
+        TEST(std::equal(batch.offsets.begin(), batch.offsets.end(), expect_offsets.begin(), expect_offsets.end()));
+        TEST(batch.factors == expect_factors);
+    }
+
+    std::vector<uint32_t> values32;
+    for (int i = 0; i < 1000; ++i)
+        values32.push_back(uint32_t(dist32(rng)));
+
+    FactorBatch<uint32_t> batch32;
+    TRY(batch32 = factor_batch(values32.data(), values32.size()));
+    TEST_EQUAL(batch32.offsets.size(), values32.size() + 1);
+
+    for (size_t i = 0; i < values32.size(); ++i) {
+        std::vector<uint32_t> f(batch32.factors.begin() + batch32.offsets[i], batch32.factors.begin() + batch32.offsets[i + 1]);
+        TEST_EQUAL(format_range(f), format_range(prime_factors(values32[i])));
+    }
+
 }
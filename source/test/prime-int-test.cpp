@@ -1,7 +1,10 @@
 #include "rs-sci/prime.hpp"
 #include "rs-format/format.hpp"
 #include "rs-unit-test.hpp"
+#include <cstdint>
+#include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace RS::Format;
@@ -153,6 +156,28 @@ void test_rs_sci_prime_iterator_int() {
         TRY(++it);
     }
 
+    // Long enough to cross several sieve windows
+
+    static constexpr uint64_t limit = 5'000'000;
+
+    PrimeGenerator<uint64_t> gen64;
+    PrimeGenerator<uint64_t> copy;
+    std::vector<uint64_t> v, w;
+
+    TRY(w = prime_list(limit));
+    for (uint64_t q = 0; (q = gen64()) <= limit;) {
+        v.push_back(q);
+        if (q == 999'983)
+            copy = gen64;
+    }
+    TEST_EQUAL(v.size(), w.size());
+    TEST(v == w);
+
+    TRY(p = int(copy()));
+    TEST_EQUAL(p, 1'000'003);
+    TRY(p = int(copy()));
+    TEST_EQUAL(p, 1'000'033);
+
 }
 
 void test_rs_sci_prime_primality_int() {
@@ -191,6 +216,54 @@ void test_rs_sci_prime_primality_int() {
     TEST(! is_prime(123456789));
     TEST(is_prime(987654319));
 
+    // Strong pseudoprimes to several bases, and Carmichael numbers
+
+    TEST(! is_prime(2047));
+    TEST(! is_prime(1373653));
+    TEST(! is_prime(25326001));
+    TEST(! is_prime(3215031751ull));
+    TEST(! is_prime(2152302898747ull));
+    TEST(! is_prime(3474749660383ull));
+    TEST(! is_prime(341550071728321ull));
+    TEST(! is_prime(3825123056546413051ull));
+    TEST(! is_prime(561));
+    TEST(! is_prime(1105));
+    TEST(! is_prime(1729));
+
+    TEST(is_prime(2305843009213693951ull));
+    TEST(is_prime(18446744073709551557ull));
+    TEST(! is_prime(18446744073709551559ull));
+    TEST(! is_prime(18446744073709551615ull));
+    TEST(! is_prime(-7));
+    TEST(! is_prime(int64_t(-9223372036854775807ll)));
+
+    // Evaluated at compile time
+
+    static constexpr bool constant_results[] = {
+        is_prime(65'521),
+        is_prime(65'535),
+        is_prime(4'294'967'291u),
+        is_prime(4'294'967'295u),
+        is_prime(uint64_t(18'446'744'073'709'551'557u)),
+        is_prime(uint64_t(18'446'744'073'709'551'559u)),
+    };
+
+    TEST(constant_results[0]);
+    TEST(! constant_results[1]);
+    TEST(constant_results[2]);
+    TEST(! constant_results[3]);
+    TEST(constant_results[4]);
+    TEST(! constant_results[5]);
+
+    std::vector<uint32_t> primes, found;
+
+    TRY(primes = prime_list(uint32_t(1'000'000)));
+    for (uint32_t n = 0; n <= 1'000'000; ++n)
+        if (is_prime(n))
+            found.push_back(n);
+    TEST_EQUAL(found.size(), primes.size());
+    TEST(found == primes);
+
 }
 
 void test_rs_sci_prime_list_primes_int() {
@@ -210,4 +283,168 @@ void test_rs_sci_prime_list_primes_int() {
     TRY(s = format_range(v));
     TEST_EQUAL(s, "[101,103,107,109,113,127,131,137,139,149,151,157,163,167,173,179,181,191,193,197,199]");
 
+    for (int m = -5; m <= 250; ++m) {
+        for (int n = m - 1; n <= 250; ++n) {
+            std::vector<int> expect;
+            for (auto p: primes_to_10k)
+                if (p >= m && p <= n)
+                    expect.push_back(p);
+            TRY(v = prime_list(m, n));
+            TEST_EQUAL(format_range(v), format_range(expect));
+        }
+    }
+
+    TRY(v = prime_list(10'000));
+    TEST_EQUAL(v.size(), std::size(primes_to_10k));
+    TEST_EQUAL(format_range(v), format_range(primes_to_10k));
+
+}
+
+void test_rs_sci_prime_sieve_int() {
+
+    static const std::pair<uint64_t, uint64_t> ranges[] = {
+        { 0,                            1'000'000 },
+        { 999'000,                      2'000'000 },
+        { 1'000'000'000'000,            1'000'000'100'000 },
+        { 4'294'967'000,                4'294'968'000 },
+        { 18'446'744'073'709'000'000u,  18'446'744'073'709'551'615u },
+    };
+
+    std::vector<uint64_t> v, w, block;
+
+    for (auto [m,n]: ranges) {
+
+        w.clear();
+        for (uint64_t i = m;; ++i) {
+            if (is_prime(i))
+                w.push_back(i);
+            if (i == n)
+                break;
+        }
+
+        TRY(v = prime_list(m, n));
+        TEST_EQUAL(v.size(), w.size());
+        TEST(v == w);
+
+        for (size_t segment: { 1, 7, 100, 4096 }) {
+            if (n > 10'000'000 && segment < 4096)
+                continue; // Too slow with this many sieving primes
+            PrimeSieve sieve(m, n, segment);
+            v.clear();
+            while (sieve.next(block))
+                v.insert(v.end(), block.begin(), block.end());
+            TEST_EQUAL(v.size(), w.size());
+            TEST(v == w);
+        }
+
+    }
+
+    for (uint64_t m = 0; m <= 100; ++m) {
+        for (uint64_t n = m - (m > 0); n <= 100; ++n) {
+            w.clear();
+            for (uint64_t p: primes_to_10k)
+                if (p >= m && p <= n)
+                    w.push_back(p);
+            PrimeSieve sieve(m, n);
+            v.clear();
+            while (sieve.next(block))
+                v.insert(v.end(), block.begin(), block.end());
+            TEST(v == w);
+        }
+    }
+
+    TRY(v = prime_list(uint64_t(1'000'000'000'000), uint64_t(1'000'100'000'000)));
+    TEST_EQUAL(v.size(), 3'618'282u);
+
+    {
+        PrimeSieve sieve(100, 10);
+        TEST(! sieve.next(block));
+        TEST(block.empty());
+    }
+
+}
+
+void test_rs_sci_prime_parallel_sieve_int() {
+
+    static const std::pair<uint64_t, uint64_t> ranges[] = {
+        { 0,                  100 },
+        { 0,                  10'000'000 },
+        { 1'000'000'000'000,  1'000'020'000'000 },
+    };
+
+    std::vector<uint64_t> v, w;
+
+    for (auto [m,n]: ranges) {
+        TRY(w = prime_list(m, n));
+        for (size_t threads: { 0, 1, 2, 3, 8 }) {
+            TRY(v = parallel_prime_list(m, n, threads));
+            TEST_EQUAL(v.size(), w.size());
+            TEST(v == w);
+            TEST_EQUAL(parallel_prime_count(m, n, threads), w.size());
+        }
+    }
+
+    // Near the top of the range a chunk is at least sqrt(n) wide, so the
+    // number of threads makes no difference here
+
+    static constexpr uint64_t top_m = 18'446'744'073'708'000'000u;
+    static constexpr uint64_t top_n = 18'446'744'073'709'551'615u;
+
+    TRY(w = prime_list(top_m, top_n));
+    TRY(v = parallel_prime_list(top_m, top_n));
+    TEST_EQUAL(v.size(), w.size());
+    TEST(v == w);
+    TEST_EQUAL(parallel_prime_count(top_m, top_n), w.size());
+
+    TEST_EQUAL(parallel_prime_count(0, 0),                  0u);
+    TEST_EQUAL(parallel_prime_count(0, 1),                  0u);
+    TEST_EQUAL(parallel_prime_count(0, 2),                  1u);
+    TEST_EQUAL(parallel_prime_count(0, 10),                 4u);
+    TEST_EQUAL(parallel_prime_count(0, 1'000'000),          78'498u);
+    TEST_EQUAL(parallel_prime_count(0, 1'000'000'000),      50'847'534u);
+    TEST_EQUAL(parallel_prime_count(100, 10),               0u);
+
+    TRY(v = parallel_prime_list(100, 10));
+    TEST(v.empty());
+
+}
+
+void test_rs_sci_prime_count_int() {
+
+    TEST_EQUAL(prime_count(-1),                             0);
+    TEST_EQUAL(prime_count(0),                              0);
+    TEST_EQUAL(prime_count(1),                              0);
+    TEST_EQUAL(prime_count(2),                              1);
+    TEST_EQUAL(prime_count(10),                             4);
+    TEST_EQUAL(prime_count(100),                            25);
+    TEST_EQUAL(prime_count(1'000'000),                      78'498);
+    TEST_EQUAL(prime_count(2'147'483'647),                  105'097'565);
+    TEST_EQUAL(prime_count(uint64_t(1'000'000'000)),        50'847'534u);
+    TEST_EQUAL(prime_count(uint64_t(4'294'967'296u)),       203'280'221u);
+    TEST_EQUAL(prime_count(uint64_t(10'000'000'000u)),      455'052'511u);
+    TEST_EQUAL(prime_count(uint64_t(100'000'000'000u)),     4'118'054'813u);
+    TEST_EQUAL(prime_count(uint64_t(1'000'000'000'000u)),   37'607'912'018u);
+
+    // Compare with the sieve around the switch to Meissel's formula, and
+    // at prime squares and cubes where the boundary cases change
+
+    static constexpr uint64_t primes[] = { 101, 211, 577, 997, 1'009, 2'003, 10'007 };
+
+    std::vector<uint64_t> values;
+
+    for (uint64_t n = 999'990; n <= 1'000'010; ++n)
+        values.push_back(n);
+    for (auto p: primes) {
+        for (uint64_t q: { p * p, p * p * p }) {
+            if (q < 200'000'000) {
+                values.push_back(q - 1);
+                values.push_back(q);
+                values.push_back(q + 1);
+            }
+        }
+    }
+
+    for (auto n: values)
+        TEST_EQUAL(prime_count(n), parallel_prime_count(0, n, 1));
+
 }
@@ -172,6 +172,22 @@ void test_rs_sci_prime_primality_mp_integer() {
     TEST(! is_prime(MPZ(10)));
     TEST(! is_prime(MPZ(123456789)));
     TEST(is_prime(MPZ(987654319)));
+    TEST(! is_prime(MPZ(-7)));
+
+    // Strong pseudoprimes to several bases
+
+    TEST(! is_prime(MPN("3215031751")));
+    TEST(! is_prime(MPN("3825123056546413051")));
+    TEST(! is_prime(MPN("318665857834031151167461")));
+    TEST(! is_prime(MPN("3317044064679887385961981")));
+
+    TEST(is_prime(MPN("18446744073709551629")));
+    TEST(is_prime(MPN("170141183460469231731687303715884105727")));
+    TEST(! is_prime(MPN("170141183460469231731687303715884105729")));
+    TEST(is_prime((MPN(1) << 521) - 1));
+    TEST(! is_prime((MPN(1) << 523) - 1));
+    TEST(! is_prime(MPN("10000000000000000000000000000000000000121") * MPN("18446744073709551629")));
+    TEST(! is_prime(MPN("18446744073709551629") * MPN("18446744073709551629")));
 
 }
 
@@ -200,10 +216,18 @@ void test_rs_sci_prime_next_prev_prime_mp_integer() {
     TRY(n = MPZ(131070));  TRY(p = next_prime(n));  TEST_EQUAL(p, MPZ(131071));  TRY(q = prev_prime(n));  TEST_EQUAL(q, MPZ(131063));
     TRY(n = MPZ(131071));  TRY(p = next_prime(n));  TEST_EQUAL(p, MPZ(131071));  TRY(q = prev_prime(n));  TEST_EQUAL(q, MPZ(131071));
 
+    TRY(n = MPZ("18446744073709551616"));
+    TRY(p = next_prime(n));  TEST_EQUAL(p, MPZ("18446744073709551629"));
+    TRY(q = prev_prime(n));  TEST_EQUAL(q, MPZ("18446744073709551557"));
+    TRY(n = MPZ("10000000000000000000000000000000000000000"));
+    TRY(p = next_prime(n));  TEST_EQUAL(p, MPZ("10000000000000000000000000000000000000121"));
+    TRY(q = prev_prime(n));  TEST_EQUAL(q, MPZ("9999999999999999999999999999999999999983"));
+
 }
 
 void test_rs_sci_prime_factorization_mp_integer() {
 
+    MPZ n;
     std::vector<MPZ> v;
     std::map<MPZ, MPZ> m;
     std::string s;
@@ -246,6 +270,22 @@ void test_rs_sci_prime_factorization_mp_integer() {
     TRY(m = prime_factors_map(MPZ(123456789)));  TRY(s = format_map(m));  TEST_EQUAL(s, "{3:2,3607:1,3803:1}");
     TRY(m = prime_factors_map(MPZ(987654319)));  TRY(s = format_map(m));  TEST_EQUAL(s, "{987654319:1}");
 
+    TRY(v = prime_factors(MPZ(-12)));  TRY(s = format_range(v));  TEST_EQUAL(s, "[]");
+
+    TRY(n = MPZ("18446744073709551617"));
+    TRY(v = prime_factors(n));  TRY(s = format_range(v));  TEST_EQUAL(s, "[274177,67280421310721]");
+    TRY(n = MPZ("340282366920938463463374607431768211455"));
+    TRY(v = prime_factors(n));  TRY(s = format_range(v));  TEST_EQUAL(s, "[3,5,17,257,641,65537,274177,6700417,67280421310721]");
+    TRY(n = MPZ("2417851639386226726128374289975643571"));
+    TRY(v = prime_factors(n));  TRY(s = format_range(v));  TEST_EQUAL(s, "[1000000000039,1099511627791,2199023255579]");
+    TRY(n = MPZ("2658455991675008292115472243411130299"));
+    TRY(v = prime_factors(n));  TRY(s = format_range(v));  TEST_EQUAL(s, "[1099511627791,1099511627791,2199023255579]");
+    TRY(m = prime_factors_map(n));  TRY(s = format_map(m));  TEST_EQUAL(s, "{1099511627791:2,2199023255579:1}");
+    TRY(n = MPZ("5461926853160471027050739151"));
+    TRY(m = prime_factors_map(n));  TRY(s = format_map(m));  TEST_EQUAL(s, "{3:2,251:1,1099511627791:1,2199023255579:1}");
+    TRY(n = MPZ("10000000000000000000000000000000000000121"));
+    TRY(v = prime_factors(n));  TRY(s = format_range(v));  TEST_EQUAL(s, "[10000000000000000000000000000000000000121]");
+
 }
 
 void test_rs_sci_prime_list_primes_mp_integer() {
@@ -265,4 +305,30 @@ void test_rs_sci_prime_list_primes_mp_integer() {
     TRY(s = format_range(v));
     TEST_EQUAL(s, "[101,103,107,109,113,127,131,137,139,149,151,157,163,167,173,179,181,191,193,197,199]");
 
+    TRY(v = prime_list(MPZ("18446744073709551516"), MPZ("18446744073709551916")));
+    TEST_EQUAL(v.size(), 9u);
+    TRY(s = format_range(v));
+    TEST_EQUAL(s, "[18446744073709551521,18446744073709551533,18446744073709551557,18446744073709551629,"
+        "18446744073709551653,18446744073709551667,18446744073709551697,18446744073709551709,18446744073709551757]");
+
+    TRY(v = prime_list(MPZ("18446744073709551500"), MPZ("18446744073709551615")));
+    TRY(s = format_range(v));
+    TEST_EQUAL(s, "[18446744073709551521,18446744073709551533,18446744073709551557]");
+
+    TRY(v = prime_list(MPZ("-10"), MPZ("10")));
+    TRY(s = format_range(v));
+    TEST_EQUAL(s, "[2,3,5,7]");
+
+}
+
+void test_rs_sci_prime_count_mp_integer() {
+
+    MPZ n;
+
+    TRY(n = prime_count(MPZ(-10)));                       TEST_EQUAL(n, 0);
+    TRY(n = prime_count(MPZ(1000)));                      TEST_EQUAL(n, 168);
+    TRY(n = prime_count(MPZ("1000000000000")));           TEST_EQUAL(n.str(), "37607912018");
+    TRY(n = prime_count(MPN("10000000000")));             TEST_EQUAL(n.str(), "455052511");
+    TEST_THROW(prime_count(MPZ("18446744073709551616")),  std::out_of_range);
+
 }
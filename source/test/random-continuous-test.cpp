@@ -4,6 +4,7 @@
 #include "rs-unit-test.hpp"
 #include <array>
 #include <cmath>
+#include <vector>
 
 using namespace RS::Sci;
 
@@ -267,3 +268,85 @@ void test_rs_sci_random_log_normal_distribution() {
     TEST_NEAR(stats.sd(), 2.303, 0.01);
 
 }
+
+void test_rs_sci_random_continuous_generate() {
+
+    static constexpr size_t size = 1001;
+
+    std::vector<double> out(size);
+    double x = 0;
+
+    // Uniform values are the same as calling the distribution repeatedly,
+    // with or without a bulk engine
+
+    Pcg64 rng(42);
+    XoshiroX8 rng8(42);
+    UniformReal<double> ur(10, 20);
+
+    auto copy = rng;
+    TRY(ur.generate(rng, out.data(), size));
+    for (auto y: out) {
+        TRY(x = ur(copy));
+        TEST_EQUAL(y, x);
+    }
+
+    auto copy8 = rng8;
+    TRY(ur.generate(rng8, out.data(), size));
+    for (auto y: out) {
+        TRY(x = ur(copy8));
+        TEST_EQUAL(y, x);
+    }
+
+    // Normal values come in pairs; the first of each pair is the same as
+    // calling the distribution
+
+    NormalDistribution<double> norm(100, 50);
+    copy = rng;
+    TRY(norm.generate(rng, out.data(), size));
+
+    for (size_t i = 0; i < size; i += 2) {
+        TRY(x = norm(copy));
+        TEST_NEAR(out[i], x, 1e-12);
+    }
+
+    static constexpr size_t big_size = 1'000'000;
+
+    std::vector<double> big(big_size);
+    Statistics<double> even, odd;
+
+    TRY(norm.generate(rng, big.data(), big_size));
+    for (size_t i = 0; i < big_size; i += 2) {
+        even(big[i]);
+        odd(big[i + 1]);
+    }
+
+    TEST_NEAR(even.mean(), 100, 0.2);
+    TEST_NEAR(even.sd(), 50, 0.2);
+    TEST_NEAR(odd.mean(), 100, 0.2);
+    TEST_NEAR(odd.sd(), 50, 0.2);
+
+    // The sine and cosine outputs of each pair are independent
+
+    Statistics<double> pairs;
+
+    for (size_t i = 0; i < big_size; i += 2)
+        pairs(big[i], big[i + 1]);
+
+    TEST_NEAR(pairs.r(), 0, 0.005);
+
+    LogNormal<double> ln;
+    Statistics<double> stats;
+
+    TRY(ln.generate(rng, big.data(), big_size));
+    for (auto y: big)
+        stats(std::log(y));
+
+    TEST_NEAR(stats.mean(), 0, 0.005);
+    TEST_NEAR(stats.sd(), 1, 0.005);
+
+    LogUniform<double> lu(1, 100);
+    TRY(lu.generate(rng, out.data(), size));
+    for (auto y: out)
+        TEST(y >= 1 && y < 100);
+
+}
@@ -4,6 +4,7 @@
 #include "rs-unit-test.hpp"
 #include <cmath>
 #include <map>
+#include <vector>
 
 using namespace RS::Sci;
 
@@ -206,3 +207,84 @@ void test_rs_sci_random_poisson_distribution() {
     TEST_NEAR(stats.sd(), poi.sd(), 0.1);
 
 }
+
+void test_rs_sci_random_discrete_generate() {
+
+    static constexpr size_t size = 1001;
+
+    Pcg64 rng(42);
+
+    {
+        UniformInteger<int> dist(1, 6);
+        std::vector<int> out(size);
+        int x = 0;
+        auto copy = rng;
+        TRY(dist.generate(rng, out.data(), size));
+        for (auto y: out) {
+            TRY(x = dist(copy));
+            TEST_EQUAL(y, x);
+        }
+    }
+
+    {
+        UniformInteger<uint64_t> dist(0, ~ uint64_t(0));
+        std::vector<uint64_t> out(size);
+        uint64_t x = 0;
+        auto copy = rng;
+        TRY(dist.generate(rng, out.data(), size));
+        for (auto y: out) {
+            TRY(x = dist(copy));
+            TEST_EQUAL(y, x);
+        }
+    }
+
+    {
+        UniformInteger<int> dist(1, 6);
+        XoshiroX8 rng8(42);
+        std::vector<int> out(size);
+        int x = 0;
+        auto copy8 = rng8;
+        TRY(dist.generate(rng8, out.data(), size));
+        for (auto y: out) {
+            TRY(x = dist(copy8));
+            TEST_EQUAL(y, x);
+        }
+    }
+
+    {
+        BernoulliDistribution dist(0.25);
+        bool out[size] = {};
+        bool x = false;
+        auto copy = rng;
+        TRY(dist.generate(rng, out, size));
+        for (auto y: out) {
+            TRY(x = dist(copy));
+            TEST_EQUAL(y, x);
+        }
+    }
+
+    for (double lambda: {5.0, 100.0}) {
+        PoissonDistribution<int> dist(lambda);
+        std::vector<int> out(size);
+        int x = 0;
+        auto copy = rng;
+        TRY(dist.generate(rng, out.data(), size));
+        for (auto y: out) {
+            TRY(x = dist(copy));
+            TEST_EQUAL(y, x);
+        }
+    }
+
+    {
+        static constexpr size_t big_size = 1'000'000;
+        DiscreteNormal<int> dist(100, 20);
+        std::vector<int> out(big_size);
+        Statistics<double> stats;
+        TRY(dist.generate(rng, out.data(), big_size));
+        for (auto y: out)
+            stats(y);
+        TEST_NEAR(stats.mean(), 100, 0.1);
+        TEST_NEAR(stats.sd(), 20, 0.1);
+    }
+
+}
@@ -2,6 +2,7 @@
 #include "rs-sci/statistics.hpp"
 #include "rs-unit-test.hpp"
 #include <cmath>
+#include <vector>
 
 using namespace RS::Sci;
 
@@ -41,3 +42,43 @@ void test_rs_sci_random_lcg_generators() {
     TEST_NEAR(stats.sd(), sd64, 1e16);
 
 }
+
+void test_rs_sci_random_lcg_advance() {
+
+    Lcg32 a32(42), b32(42);
+    Lcg64 a64(42), b64(42);
+
+    for (int i = 0; i < 1000; ++i) {
+        a32();
+        a64();
+    }
+
+    TRY(b32.advance(1000));  TEST(a32 == b32);
+    TRY(b64.advance(1000));  TEST(a64 == b64);
+    TRY(b32.advance(-1000));  TEST(b32 == Lcg32(42));
+    TRY(b64.advance(-1000));  TEST(b64 == Lcg64(42));
+    TRY(b32.advance(0));      TEST(b32 == Lcg32(42));
+    TRY(b64.advance(0));      TEST(b64 == Lcg64(42));
+
+    std::vector<Lcg32> e32;
+    std::vector<Lcg64> e64;
+
+    TRY(e32 = disjoint_engines<Lcg32>(42, 4));
+    TRY(e64 = disjoint_engines<Lcg64>(42, 3));
+    TEST_EQUAL(e32.size(), 4u);
+    TEST_EQUAL(e64.size(), 3u);
+
+    for (int i = 0; i < 4; ++i) {
+        a32.seed(42);
+        a32.advance(int64_t(i) << 30);
+        TEST(e32[i] == a32);
+    }
+
+    a64.seed(42);
+    TEST(e64[0] == a64);
+    a64.advance(int64_t(0x5555'5555'5555'5555ull));
+    TEST(e64[1] == a64);
+    a64.advance(int64_t(0x5555'5555'5555'5555ull));
+    TEST(e64[2] == a64);
+
+}
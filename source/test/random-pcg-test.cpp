@@ -67,3 +67,20 @@ void test_rs_sci_random_pcg64() {
     }
 
 }
+
+void test_rs_sci_random_pcg64_streams() {
+
+    std::vector<Pcg64> engines;
+    Pcg64 rng(42);
+
+    TRY(engines = disjoint_engines<Pcg64>(42, 3));
+    TEST_EQUAL(engines.size(), 3u);
+
+    for (auto& e: engines) {
+        auto copy = rng;
+        for (int i = 0; i < 10; ++i)
+            TEST_EQUAL(e(), copy());
+        rng.advance(int64_t(1) << 62);
+    }
+
+}
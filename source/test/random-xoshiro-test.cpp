@@ -1,5 +1,6 @@
 #include "rs-sci/random-engines.hpp"
 #include "rs-unit-test.hpp"
+#include <algorithm>
 #include <vector>
 
 using namespace RS::Sci;
@@ -66,3 +67,95 @@ void test_rs_sci_random_xoshiro256ss() {
     }
 
 }
+
+void test_rs_sci_random_xoshiro_jump() {
+
+    // Expected states calculated independently, by raising the transition
+    // matrix over GF(2) to the power 2^128 or 2^192
+
+    Xoshiro rng(0x0123'4567'89ab'cdefull, 0xfedc'ba98'7654'3210ull, 0x1111'1111'2222'2222ull, 0x3333'3333'4444'4444ull);
+    Xoshiro jumped(0xf0e9'b989'4bca'0e8cull, 0x21e9'8c59'0df5'44bfull, 0xbf3b'd30f'7c2d'c469ull, 0x606c'6d2a'0419'3847ull);
+    Xoshiro long_jumped(0x6324'3974'0fd6'c9bdull, 0xa5ae'8721'1152'cea0ull, 0xd53a'd2dd'5a2c'fa8cull, 0x6bd8'5dae'05d9'546eull);
+    Xoshiro copy = rng;
+
+    TRY(rng.jump());
+    TRY(copy.long_jump());
+
+    for (int i = 0; i < 10; ++i) {
+        TEST_EQUAL(rng(), jumped());
+        TEST_EQUAL(copy(), long_jumped());
+    }
+
+    std::vector<Xoshiro> engines;
+
+    TRY(engines = disjoint_engines<Xoshiro>(42, 3));
+    TEST_EQUAL(engines.size(), 3u);
+    TRY(rng.seed(42));
+
+    for (auto& e: engines) {
+        copy = rng;
+        for (int i = 0; i < 10; ++i)
+            TEST_EQUAL(e(), copy());
+        rng.jump();
+    }
+
+}
+
+void test_rs_sci_random_xoshiro_x8() {
+
+    static constexpr size_t lanes = XoshiroX8::lanes;
+    static constexpr size_t total = 1000;
+
+    // Lane j is the scalar generator after j jumps
+
+    std::vector<Xoshiro> scalar(lanes, Xoshiro(42));
+    std::vector<uint64_t> expect(total);
+
+    for (size_t j = 0; j < lanes; ++j)
+        for (size_t k = 0; k < j; ++k)
+            scalar[j].jump();
+
+    for (size_t i = 0; i < total; ++i)
+        expect[i] = scalar[i % lanes]();
+
+    // Every combination of the optional instruction set extensions gives
+    // the same results, whatever the processor actually has
+
+    static const std::vector<unsigned> masks = {
+        random_use_all,
+        random_use_avx2,
+        0,
+    };
+
+    for (auto mask: masks) {
+
+        TRY(set_random_extensions(mask));
+        TEST_EQUAL(random_extensions(), mask);
+
+        XoshiroX8 rng(42);
+        std::vector<uint64_t> out(total);
+
+        TRY(rng.fill(out.data(), total));
+        TEST(out == expect);
+
+        // Any mixture of fill() and operator() gives the same sequence
+
+        TRY(rng.seed(42));
+        std::fill(out.begin(), out.end(), 0);
+        size_t i = 0;
+
+        for (size_t n: {3, 1, 8, 0, 17, 5, 64, 2, 100}) {
+            TRY(rng.fill(out.data() + i, n));
+            i += n;
+            TRY(out[i++] = rng());
+        }
+
+        TRY(rng.fill(out.data() + i, total - i));
+        TEST(out == expect);
+
+    }
+
+    TRY(set_random_extensions(random_use_all));
+    TEST_EQUAL(random_extensions(), random_use_all);
+
+}
@@ -1,5 +1,6 @@
 #include "rs-sci/rational.hpp"
 #include "rs-unit-test.hpp"
+#include <functional>
 #include <stdexcept>
 #include <unordered_set>
 
@@ -211,4 +212,13 @@ void test_rs_sci_rational_hash() {
 
     TEST_EQUAL(ratset.size(), 10u);
 
+    Rational r(3, 4);
+    int parts[] = {3, 4};
+    size_t h1 = std::hash<int>()(3), h2 = std::hash<int>()(4);
+
+    TEST_EQUAL(r.hash(), size_t(bulk_hash64(parts, sizeof(parts))));
+    TEST_EQUAL(r.legacy_hash(), h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2)));
+    TEST(Rational(4, 3).hash() != r.hash());
+    TEST(Rational(-3, 4).hash() != r.hash());
+
 }
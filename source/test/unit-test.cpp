@@ -41,10 +41,18 @@ int main(int argc, char** argv) {
 
     // hash-test.cpp
     UNIT_TEST(rs_sci_hash_siphash)
+    UNIT_TEST(rs_sci_hash_siphash13)
+    UNIT_TEST(rs_sci_hash_halfsiphash)
     UNIT_TEST(rs_sci_hash_md5)
     UNIT_TEST(rs_sci_hash_sha1)
     UNIT_TEST(rs_sci_hash_sha256)
     UNIT_TEST(rs_sci_hash_sha512)
+    UNIT_TEST(rs_sci_hash_digest)
+    UNIT_TEST(rs_sci_hash_sha2_block_boundaries)
+    UNIT_TEST(rs_sci_hash_batch)
+    UNIT_TEST(rs_sci_hash_bulk_hash)
+    UNIT_TEST(rs_sci_hash_bulk_hasher)
+    UNIT_TEST(rs_sci_hash_instruction_sets)
 
     // rational-test.cpp
     UNIT_TEST(rs_sci_rational_basics)
@@ -61,9 +69,15 @@ int main(int argc, char** argv) {
     UNIT_TEST(rs_sci_mp_integer_unsigned_conversion_strings)
     UNIT_TEST(rs_sci_mp_integer_unsigned_conversion_base_strings)
     UNIT_TEST(rs_sci_mp_integer_unsigned_conversion_double)
+    UNIT_TEST(rs_sci_mp_integer_unsigned_conversion_large_strings)
 
     // mp-integer-unsigned-arithmetic-test.cpp
     UNIT_TEST(rs_sci_mp_integer_unsigned_arithmetic)
+    UNIT_TEST(rs_sci_mp_integer_unsigned_multiplication_algorithms)
+    UNIT_TEST(rs_sci_mp_integer_unsigned_ntt_multiplication)
+    UNIT_TEST(rs_sci_mp_integer_unsigned_division)
+    UNIT_TEST(rs_sci_mp_integer_unsigned_fused_arithmetic)
+    UNIT_TEST(rs_sci_mp_integer_unsigned_modular_arithmetic)
     UNIT_TEST(rs_sci_mp_integer_unsigned_arithmetic_powers)
     UNIT_TEST(rs_sci_mp_integer_unsigned_bit_operations)
     UNIT_TEST(rs_sci_mp_integer_unsigned_byte_operations)
@@ -78,12 +92,15 @@ int main(int argc, char** argv) {
     UNIT_TEST(rs_sci_mp_integer_signed_arithmetic)
     UNIT_TEST(rs_sci_mp_integer_signed_division)
     UNIT_TEST(rs_sci_mp_integer_signed_large_arithmetic)
+    UNIT_TEST(rs_sci_mp_integer_signed_fused_arithmetic)
     UNIT_TEST(rs_sci_mp_integer_signed_powers)
 
     // mp-integer-sign-agnostic-test.cpp
     UNIT_TEST(rs_sci_mp_integer_literals)
     UNIT_TEST(rs_sci_mp_integer_core_functions)
     UNIT_TEST(rs_sci_mp_integer_hash_set)
+    UNIT_TEST(rs_sci_mp_integer_hash_limb_width)
+    UNIT_TEST(rs_sci_mp_integer_limb_storage)
 
     // mp-integer-rational-arithmetic-test.cpp
     UNIT_TEST(rs_sci_mp_integer_rational_reduction)
@@ -100,12 +117,17 @@ int main(int argc, char** argv) {
     UNIT_TEST(rs_sci_prime_iterator_int)
     UNIT_TEST(rs_sci_prime_primality_int)
     UNIT_TEST(rs_sci_prime_list_primes_int)
+    UNIT_TEST(rs_sci_prime_sieve_int)
+    UNIT_TEST(rs_sci_prime_parallel_sieve_int)
+    UNIT_TEST(rs_sci_prime_count_int)
 
     // prime-int-next-prev-test.cpp
     UNIT_TEST(rs_sci_prime_next_prev_prime_int)
 
     // prime-int-factors-test.cpp
     UNIT_TEST(rs_sci_prime_factorization_int)
+    UNIT_TEST(rs_sci_prime_factorization_int64)
+    UNIT_TEST(rs_sci_prime_factorization_batch)
 
     // prime-fixed-binary-test.cpp
     UNIT_TEST(rs_sci_prime_iterator_fixed_binary)
@@ -120,21 +142,27 @@ int main(int argc, char** argv) {
     UNIT_TEST(rs_sci_prime_next_prev_prime_mp_integer)
     UNIT_TEST(rs_sci_prime_factorization_mp_integer)
     UNIT_TEST(rs_sci_prime_list_primes_mp_integer)
+    UNIT_TEST(rs_sci_prime_count_mp_integer)
 
     // random-lcg-test.cpp
     UNIT_TEST(rs_sci_random_lcg_generators)
+    UNIT_TEST(rs_sci_random_lcg_advance)
 
     // random-pcg-test.cpp
     UNIT_TEST(rs_sci_random_pcg64)
+    UNIT_TEST(rs_sci_random_pcg64_streams)
 
     // random-xoshiro-test.cpp
     UNIT_TEST(rs_sci_random_splitmix64)
     UNIT_TEST(rs_sci_random_xoshiro256ss)
+    UNIT_TEST(rs_sci_random_xoshiro_jump)
+    UNIT_TEST(rs_sci_random_xoshiro_x8)
 
     // random-discrete-test.cpp
     UNIT_TEST(rs_sci_random_bernoulli_distribution)
     UNIT_TEST(rs_sci_random_uniform_integer_distribution)
     UNIT_TEST(rs_sci_random_poisson_distribution)
+    UNIT_TEST(rs_sci_random_discrete_generate)
 
     // random-continuous-test.cpp
     UNIT_TEST(rs_sci_random_uniform_real_distribution_properties)
@@ -143,6 +171,7 @@ int main(int argc, char** argv) {
     UNIT_TEST(rs_sci_random_normal_distribution_properties)
     UNIT_TEST(rs_sci_random_normal_distribution)
     UNIT_TEST(rs_sci_random_log_normal_distribution)
+    UNIT_TEST(rs_sci_random_continuous_generate)
 
     // random-adapter-test.cpp
     UNIT_TEST(rs_sci_random_constrained_distribution)